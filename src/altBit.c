@@ -4,47 +4,11 @@
 #include <assert.h>
 #include <time.h>
 #include <stdarg.h>
+#include <stdint.h>
 
-/* ******************************************************************
- ALTERNATING BIT AND GO-BACK-N NETWORK EMULATOR: VERSION 1.1  J.F.Kurose
-
-   This code should be used for PA2, unidirectional or bidirectional
-   data transfer protocols (from A to B. Bidirectional transfer of data
-   is for extra credit and is not required).  Network properties:
-   - one way network delay averages five time units (longer if there
-       are other messages in the channel for GBN), but can be larger
-   - packets can be corrupted (either the header or the data portion)
-       or lost, according to user-defined probabilities
-   - packets will be delivered in the order in which they were sent
-       (although some can be lost).
-**********************************************************************/
-
-#define BIDIRECTIONAL 0 /* change to 1 if you're doing extra credit */
-/* and write a routine called B_output */
-
-/* a "msg" is the data unit passed from layer 5 (teachers code) to layer  */
-/* 4 (students' code).  It contains the data (characters) to be delivered */
-/* to layer 5 via the students transport level protocol entities.         */
-struct msg
-{
-    char data[20];
-};
-
-/* a packet is the data unit passed from layer 4 (students code) to layer */
-/* 3 (teachers code).  Note the pre-defined packet structure, which all   */
-/* students must follow. */
-struct pkt
-{
-    int seqnum;
-    int acknum;
-    int checksum;
-    char payload[20];
-};
-
-void starttimer(int AorB, float increment);
-void stoptimer(int AorB);
-void tolayer3(int AorB, struct pkt packet);
-void tolayer5(int AorB, char datasent[20]);
+#include "emulator.h"
+#include "checksum.h"
+#include "log.h"
 
 /********* STUDENTS WRITE THE NEXT SEVEN ROUTINES *********/
 /************ STUDENTS NEED TO MODIFY BELOW CODE************/
@@ -52,85 +16,85 @@ void tolayer5(int AorB, char datasent[20]);
 // Pre Define
 #define A 0
 #define B 1
-#define TIMEOUT 20
 #define WAIT 1
 #define ACTIVE 0
-#define BUF_SZ 10000
-
-int STATE;
-int buf_loc;
-int buf_ptr;
-char **buffer;
-uint32_t A_seqnum;
-uint32_t B_acknum;
 
-char* last_msg;
+const char *sim_name = "Stop and Wait";
 
-void inform(const char* __func, const char* format, ...);
-
-int calc_cSum(struct pkt packet)
+struct proto_state
 {
-    int c_sum = 0;
-    int len = sizeof(packet.payload) / sizeof(char);
-    c_sum += packet.seqnum;
-    c_sum += packet.acknum;
+    int STATE;
+    int buf_loc;
+    int buf_ptr; // the message in flight while WAIT, then those queued
+    int buf_size; // slots allocated, doubles when the queue fills up
+    char *buffer; // payload_size bytes a slot
+    uint32_t *buffer_cksum; // payload partial checksum of each slot
+    uint32_t ack_partial; // payload partial checksum of an (empty) ACK
+    uint32_t A_seqnum;
+    uint32_t B_acknum;
 
-    for(int i = 0; i < len; ++i)
-        c_sum += packet.payload[i];
+    char* last_msg; // slot buf_ptr, what a resend sends
+    float sent_at; // when last_msg was first sent ...
+    int resent;    // ... and whether it has been sent again since (Karn)
+};
 
-    return c_sum;
+int calc_cSum(struct sim_ctx *ctx, const struct pkt *packet)
+{
+    uint32_t partial = cksum_payload(ctx->cfg.cksum_kind, packet->payload, packet->length);
+    return cksum_finish(ctx->cfg.cksum_kind, partial, packet->seqnum, packet->acknum);
 }
 
-int checksum(struct pkt packet)
+int checksum(struct sim_ctx *ctx, const struct pkt *packet)
 {
-    return calc_cSum(packet) == packet.checksum ? 1 : 0;
+    return calc_cSum(ctx, packet) == packet->checksum ? 1 : 0;
 }
 
-struct pkt make_packet(uint32_t seqnum, char payload[20])
+// partial: cksum_payload() of payload, kept by the caller for resends
+struct pkt make_packet(struct sim_ctx *ctx, uint32_t seqnum, char *payload, uint32_t partial)
 {
     struct pkt packet;
     packet.seqnum = seqnum;
     packet.acknum = 0;
-    for(int i = 0; i < 20; i++)
-        packet.payload[i] = payload[i];
-    packet.checksum = calc_cSum(packet);
+    packet.length = ctx->cfg.payload_size;
+    packet.payload = payload; // tolayer3 takes its own copy
+    packet.checksum = cksum_finish(ctx->cfg.cksum_kind, partial, seqnum, 0);
     return packet;
 }
 
-void send_packet(int AorB, uint32_t seqnum, char payload[20])
+void send_packet(struct sim_ctx *ctx, int AorB, uint32_t seqnum, char *payload, uint32_t partial)
 {
     const char* sender = A == AorB ? "A_output" : "B_output";
-    inform(sender, "Send Pkt | Seq: %d | Msg: %.20s", seqnum, payload);
-    struct pkt packet = make_packet(seqnum, payload);
-    tolayer3(AorB, packet);
-    starttimer(A, TIMEOUT);
+    inform(ctx, sender, "Send Pkt | Seq: %d | Msg: %.*s", seqnum, PREVIEW(ctx->cfg.payload_size), payload);
+    struct pkt packet = make_packet(ctx, seqnum, payload, partial);
+    tolayer3(ctx, AorB, &packet);
+    starttimer(ctx, A, rto_timeout(&ctx->rto));
 }
 
-struct pkt make_ack(int acknum)
+struct pkt make_ack(struct sim_ctx *ctx, int acknum)
 {
     struct pkt packet;
     packet.seqnum = acknum;
     packet.acknum = acknum;
-    for(int i = 0; i < 20; i++)
-        packet.payload[i] = 0;
-    packet.checksum = calc_cSum(packet);
+    packet.length = 0;
+    packet.payload = NULL;
+    packet.checksum = cksum_finish(ctx->cfg.cksum_kind, ctx->proto->ack_partial, acknum, acknum);
     return packet;
 }
 
-void send_ack(int AorB, int acknum)
+void send_ack(struct sim_ctx *ctx, int AorB, int acknum)
 {
     const char* sender = A == AorB ? "A_input" : "B_input";
-    inform(sender, "Send ACK[%d]", acknum);
-    struct pkt packet = make_ack(acknum);
-    tolayer3(AorB, packet);
+    inform(ctx, sender, "Send ACK[%d]", acknum);
+    struct pkt packet = make_ack(ctx, acknum);
+    tolayer3(ctx, AorB, &packet);
 }
 
-int is_ACK(struct pkt *packet, uint32_t target)
+int is_ACK(const struct pkt *packet, uint32_t target)
 {
     return (uint32_t)packet->acknum == target;
 }
 
-int is_Seq(struct pkt *packet, uint32_t target)
+int is_Seq(const struct pkt *packet, uint32_t target)
 {
     return (uint32_t)packet->seqnum == target;
 }
@@ -145,553 +109,195 @@ int get_next_Seqnum(const uint32_t* seqnum)
     return (*seqnum + 1) % 2;
 }
 
-void inform(const char* __func, const char* format, ...)
-{
-    va_list args;
-    va_start(args, format);
-    printf("[%s]: ", __func);
-    vprintf(format, args);
-    va_end(args);
-    printf("\n");
+void toggle_state(struct sim_ctx *ctx){
+    struct proto_state *s = ctx->proto;
+    if(s->STATE == ACTIVE)
+        s->STATE = WAIT;
+    else
+        s->STATE = ACTIVE;
+    sim_window(ctx, s->STATE == WAIT ? 1 : 0);
 }
 
-void toggle_state(){
-    if(STATE == ACTIVE)
-        STATE = WAIT;
-    else
-        STATE = ACTIVE;
+void grow_buffer(struct sim_ctx *ctx)
+{
+    struct proto_state *s = ctx->proto;
+    int cap = s->buf_size;
+    int count = (s->buf_loc - s->buf_ptr + cap) % cap;
+    s->buffer = (char*)ring_grow(s->buffer, ctx->cfg.payload_size, cap, s->buf_ptr, count);
+    s->buffer_cksum = (uint32_t*)ring_grow(s->buffer_cksum, sizeof(uint32_t), cap, s->buf_ptr, count);
+    s->buf_ptr = 0;
+    s->buf_loc = count;
+    s->buf_size = 2 * cap;
+    s->last_msg = s->buffer; // it moved with the rest
 }
 
-void cache_msg(struct msg* msg)
+// copy into the next free slot, nothing is allocated once the ring is big enough
+void cache_msg(struct sim_ctx *ctx, struct msg* msg)
 {
-    buffer[buf_loc] = (char *)malloc(sizeof(msg->data));
-    memcpy(buffer[buf_loc], msg->data, sizeof(msg->data));
-    buf_loc = (buf_loc + 1) % BUF_SZ;
+    struct proto_state *s = ctx->proto;
+    if((s->buf_loc + 1) % s->buf_size == s->buf_ptr)
+        grow_buffer(ctx);
+    memcpy(PAYLOAD_SLOT(ctx, s->buffer, s->buf_loc), msg->data, msg->length);
+    s->buffer_cksum[s->buf_loc] = cksum_payload(ctx->cfg.cksum_kind, msg->data, msg->length);
+    s->buf_loc = (s->buf_loc + 1) % s->buf_size;
 }
 
-/* called from layer 5, passed the data to be sent to other side */
-void A_output(struct msg message)
+// messages queued behind the one in flight
+int queued_msgs(struct sim_ctx *ctx)
 {
-    printf("------------------------------\n");
-    if (STATE == WAIT){
-        inform(__FUNCTION__, "Not yet acked, Buffer the Msg: %.20s", message.data);
-        cache_msg(&message);
+    struct proto_state *s = ctx->proto;
+    int count = (s->buf_loc - s->buf_ptr + s->buf_size) % s->buf_size;
+    return s->STATE == WAIT ? count - 1 : count;
+}
+
+/* called from layer 5, passed the data to be sent to other side */
+void A_output(struct sim_ctx *ctx, struct msg message)
+{
+    struct proto_state *s = ctx->proto;
+    LOG(ctx, LOG_INFO, "------------------------------\n");
+    cache_msg(ctx, &message);
+    if (s->STATE == WAIT){
+        inform(ctx, __FUNCTION__, "Not yet acked, Buffer the Msg: %.*s", PREVIEW(message.length), message.data);
+        sim_backlog(ctx, queued_msgs(ctx));
         return;
     }
-    strcpy(last_msg, message.data);
-    send_packet(A, A_seqnum, message.data);
-    toggle_state();
+    s->last_msg = PAYLOAD_SLOT(ctx, s->buffer, s->buf_ptr);
+    s->sent_at = ctx->time;
+    s->resent = 0;
+    send_packet(ctx, A, s->A_seqnum, s->last_msg, s->buffer_cksum[s->buf_ptr]);
+    toggle_state(ctx);
 }
 
 /* need be completed only for extra credit */
-void B_output(struct msg message)
+void B_output(struct sim_ctx *ctx, struct msg message)
 {
-    inform(__FUNCTION__, "Got Msg");
+    inform(ctx, __FUNCTION__, "Got Msg");
 }
 
 /* called from layer 3, when a packet arrives for layer 4 */
-void A_input(struct pkt packet)
+void A_input(struct sim_ctx *ctx, const struct pkt *packet)
 {
-    stoptimer(A);
-    if(!checksum(packet)){
-        inform(__FUNCTION__, "Checksum Failed");
-        send_packet(A, A_seqnum, last_msg);
+    struct proto_state *s = ctx->proto;
+    if(s->STATE == ACTIVE){ // a late copy, nothing is outstanding
+        inform(ctx, __FUNCTION__, "Nothing to ACK, Ignore");
+        return;
+    }
+    if(!checksum(ctx, packet)){
+        inform(ctx, __FUNCTION__, "Checksum Failed");
+        stoptimer(ctx, A);
+        sim_retransmit(ctx);
+        s->resent = 1;
+        send_packet(ctx, A, s->A_seqnum, s->last_msg, s->buffer_cksum[s->buf_ptr]);
     }
-    else if(!is_ACK(&packet, A_seqnum)){ // Repeat ACK
-        inform(__FUNCTION__, "Recv Repeat ACK[%d], Resending Seq[%d]", packet.acknum, A_seqnum);
-        send_packet(A, A_seqnum, last_msg);
+    else if(!is_ACK(packet, s->A_seqnum)){ // Repeat ACK
+        // answers a copy already resent; resending again on it would
+        // double every packet after one early timeout, so leave it to the timer
+        inform(ctx, __FUNCTION__, "Recv Repeat ACK[%d], Ignore", packet->acknum);
     } else { // Right ACK
-        inform(__FUNCTION__, "Recv Right ACK[%d]", packet.acknum);
-        tolayer5(A, packet.payload);
-        A_seqnum = get_next_Seqnum(&A_seqnum);
-        if(buf_loc != buf_ptr){
-            inform(__FUNCTION__, "Send Cache Msg");
-            send_packet(A, A_seqnum, buffer[buf_ptr]);
-            last_msg = buffer[buf_ptr];
-            buf_ptr = (buf_ptr + 1) % BUF_SZ;
+        stoptimer(ctx, A);
+        inform(ctx, __FUNCTION__, "Recv Right ACK[%d]", packet->acknum);
+        tolayer5(ctx, A, packet->payload, packet->length);
+        if(!s->resent)
+            rto_sample(&ctx->rto, ctx->time - s->sent_at);
+        s->A_seqnum = get_next_Seqnum(&s->A_seqnum);
+        s->buf_ptr = (s->buf_ptr + 1) % s->buf_size; // its slot is free again
+        if(s->buf_loc != s->buf_ptr){
+            inform(ctx, __FUNCTION__, "Send Cache Msg");
+            s->sent_at = ctx->time;
+            s->resent = 0;
+            s->last_msg = PAYLOAD_SLOT(ctx, s->buffer, s->buf_ptr);
+            send_packet(ctx, A, s->A_seqnum, s->last_msg, s->buffer_cksum[s->buf_ptr]);
+            sim_backlog(ctx, queued_msgs(ctx));
         }
         else{
-            toggle_state();
+            toggle_state(ctx);
         }
     }
 }
 
 /* called when A's timer goes off */
-void A_timerinterrupt(void)
+void A_timerinterrupt(struct sim_ctx *ctx)
+{
+    struct proto_state *s = ctx->proto;
+    inform(ctx, __FUNCTION__, "Resend Seq[%d] | Msg: %.*s", s->A_seqnum, PREVIEW(ctx->cfg.payload_size), s->last_msg);
+    sim_retransmit(ctx);
+    s->resent = 1;
+    rto_backoff(&ctx->rto);
+    send_packet(ctx, A, s->A_seqnum, s->last_msg, s->buffer_cksum[s->buf_ptr]);
+}
+
+/* allocate the state of both entities, once per simulation context */
+struct proto_state *proto_new(struct sim_ctx *ctx)
+{
+    struct proto_state *s = (struct proto_state*)calloc(1, sizeof(struct proto_state));
+    if(s == NULL){
+        printf("INTERNAL PANIC: out of memory for the protocol state\n");
+        exit(1);
+    }
+    s->buf_size = ctx->cfg.buf_size;
+    s->buffer = (char*)malloc((size_t)s->buf_size * ctx->cfg.payload_size);
+    s->buffer_cksum = (uint32_t*)malloc(sizeof(uint32_t) * s->buf_size);
+    if(s->buffer == NULL || s->buffer_cksum == NULL){
+        printf("INTERNAL PANIC: out of memory for %d queued messages\n", s->buf_size);
+        exit(1);
+    }
+    return s;
+}
+
+void proto_free(struct proto_state *s)
 {
-    inform(__FUNCTION__, "Resend Seq[%d] | Msg: %.20s", A_seqnum, last_msg);
-    send_packet(A, A_seqnum, last_msg);
+    free(s->buffer);
+    free(s->buffer_cksum);
+    free(s);
 }
 
 /* the following routine will be called once (only) before any other */
 /* entity A routines are called. You can use it to do any initialization */
-void A_init(void)
-{
-    A_seqnum = 0;
-    buf_loc = 0;
-    buf_ptr = 0;
-    STATE = ACTIVE;
-    last_msg = (char *)malloc(sizeof(char) * 20);
-    buffer = (char**)malloc(sizeof(char*) * BUF_SZ);
+void A_init(struct sim_ctx *ctx)
+{
+    struct proto_state *s = ctx->proto;
+    s->A_seqnum = 0;
+    s->buf_loc = 0;
+    s->buf_ptr = 0;
+    s->STATE = ACTIVE;
+    s->last_msg = s->buffer;
 }
 
 /* Note that with simplex transfer from a-to-B, there is no B_output() */
 
 /* called from layer 3, when a packet arrives for layer 4 at B*/
-void B_input(struct pkt packet)
+void B_input(struct sim_ctx *ctx, const struct pkt *packet)
 {
-    uint32_t seqnum = packet.seqnum;
-    inform(__FUNCTION__, "Recv Seq[%d] | Msg: %.20s", seqnum, packet.payload);
+    struct proto_state *s = ctx->proto;
+    uint32_t seqnum = packet->seqnum;
+    inform(ctx, __FUNCTION__, "Recv Seq[%d] | Msg: %.*s", seqnum, PREVIEW(packet->length), packet->payload);
     // CheckSum
-    if(!checksum(packet)){
-        inform(__FUNCTION__, "CheckSum failed");
-        uint32_t acknum = get_next_Acknum(&seqnum); 
-        send_ack(B, acknum);
-    } else if(is_Seq(&packet, B_acknum)){
-        inform(__FUNCTION__, "Recv Repeat Seq[%d], Resending ACK[%d]", packet.seqnum, B_acknum);
-        send_ack(B, B_acknum);
+    if(!checksum(ctx, packet)){
+        inform(ctx, __FUNCTION__, "CheckSum failed");
+        send_ack(ctx, B, s->B_acknum); // the seqnum may be the damaged part
+    } else if(is_Seq(packet, s->B_acknum)){
+        inform(ctx, __FUNCTION__, "Recv Repeat Seq[%d], Resending ACK[%d]", packet->seqnum, s->B_acknum);
+        send_ack(ctx, B, s->B_acknum);
     } else {
-        B_acknum = get_next_Acknum(&B_acknum);
-        send_ack(B, B_acknum);
-        tolayer5(B, packet.payload);
+        s->B_acknum = get_next_Acknum(&s->B_acknum);
+        send_ack(ctx, B, s->B_acknum);
+        tolayer5(ctx, B, packet->payload, packet->length);
     }
 }
 
 /* called when B's timer goes off */
-void B_timerinterrupt(void)
+void B_timerinterrupt(struct sim_ctx *ctx)
 {
-    printf("B timer time Out\n");
+    LOG(ctx, LOG_INFO, "B timer time Out\n");
 }
 
 /* the following rouytine will be called once (only) before any other */
 /* entity B routines are called. You can use it to do any initialization */
-void B_init(void)
+void B_init(struct sim_ctx *ctx)
 {
-    B_acknum = 1;
+    struct proto_state *s = ctx->proto;
+    s->B_acknum = 1;
+    s->ack_partial = cksum_payload(ctx->cfg.cksum_kind, NULL, 0);
 }
 
 /************ STUDENTS NEED TO MODIFY ABOVE CODE************/
-/*****************************************************************
-***************** NETWORK EMULATION CODE STARTS BELOW ***********
-The code below emulates the layer 3 and below network environment:
-    - emulates the transmission and delivery (possibly with bit-level corruption
-        and packet loss) of packets across the layer 3/4 interface
-    - handles the starting/stopping of a timer, and generates timer
-        interrupts (resulting in calling students timer handler).
-    - generates message to be sent (passed from later 5 to 4)
-THERE IS NOT REASON THAT ANY STUDENT SHOULD HAVE TO READ OR UNDERSTAND
-THE CODE BELOW.  YOU SHOULD NOT TOUCH, OR REFERENCE (in your code) ANY
-OF THE DATA STRUCTURES BELOW.  If you're interested in how I designed
-the emulator, you're welcome to look at the code - but again, you should have
-to, and you definitely should not have to modify
-******************************************************************/
-
-struct event
-{
-    float evtime;       /* event time */
-    int evtype;         /* event type code */
-    int eventity;       /* entity where event occurs */
-    struct pkt *pktptr; /* ptr to packet (if any) assoc w/ this event */
-    struct event *prev;
-    struct event *next;
-};
-struct event *evlist = NULL; /* the event list */
-
-/* possible events: */
-#define TIMER_INTERRUPT 0
-#define FROM_LAYER5 1
-#define FROM_LAYER3 2
-
-#define OFF 0
-#define ON 1
-#define A 0
-#define B 1
-
-int TRACE = 1;   /* for my debugging */
-int nsim = 0;    /* number of messages from 5 to 4 so far */
-int nsimmax = 0; /* number of msgs to generate, then stop */
-float g_time = 0.000;
-float lossprob;    /* probability that a packet is dropped  */
-float corruptprob; /* probability that one bit is packet is flipped */
-float lambda;      /* arrival rate of messages from layer 5 */
-int ntolayer3;     /* number sent into layer 3 */
-int nlost;         /* number lost in media */
-int ncorrupt;      /* number corrupted by media*/
-
-void init(int argc, char **argv);
-void generate_next_arrival(void);
-void insertevent(struct event *p);
-
-int main(int argc, char **argv)
-{
-    struct event *eventptr;
-    struct msg msg2give;
-    struct pkt pkt2give;
-
-    int i, j;
-    char c;
-
-    init(argc, argv);
-    A_init();
-    B_init();
-
-    while (1)
-    {
-        eventptr = evlist; /* get next event to simulate */
-        if (eventptr == NULL)
-            goto terminate;
-        evlist = evlist->next; /* remove this event from event list */
-        if (evlist != NULL)
-            evlist->prev = NULL;
-        if (TRACE >= 2)
-        {
-            printf("\nEVENT time: %f,", eventptr->evtime);
-            printf("  type: %d", eventptr->evtype);
-            if (eventptr->evtype == 0)
-                printf(", timerinterrupt  ");
-            else if (eventptr->evtype == 1)
-                printf(", fromlayer5 ");
-            else
-                printf(", fromlayer3 ");
-            printf(" entity: %d\n", eventptr->eventity);
-        }
-        g_time = eventptr->evtime; /* update time to next event time */
-        if (eventptr->evtype == FROM_LAYER5)
-        {
-            if (nsim < nsimmax)
-            {
-                if (nsim + 1 < nsimmax)
-                    generate_next_arrival(); /* set up future arrival */
-                /* fill in msg to give with string of same letter */
-                j = nsim % 26;
-                for (i = 0; i < 20; i++)
-                    msg2give.data[i] = 97 + j;
-//                msg2give.data[19] = 0;
-                if (TRACE > 2)
-                {
-                    printf("          MAINLOOP: data given to student: ");
-                    for (i = 0; i < 20; i++)
-                        printf("%c", msg2give.data[i]);
-                    printf("\n");
-                }
-                nsim++;
-                if (eventptr->eventity == A)
-                    A_output(msg2give);
-                else
-                    B_output(msg2give);
-            }
-        }
-        else if (eventptr->evtype == FROM_LAYER3)
-        {
-            pkt2give.seqnum = eventptr->pktptr->seqnum;
-            pkt2give.acknum = eventptr->pktptr->acknum;
-            pkt2give.checksum = eventptr->pktptr->checksum;
-            for (i = 0; i < 20; i++)
-                pkt2give.payload[i] = eventptr->pktptr->payload[i];
-            if (eventptr->eventity == A) /* deliver packet by calling */
-                A_input(pkt2give);       /* appropriate entity */
-            else
-                B_input(pkt2give);
-            free(eventptr->pktptr); /* free the memory for packet */
-        }
-        else if (eventptr->evtype == TIMER_INTERRUPT)
-        {
-            if (eventptr->eventity == A)
-                A_timerinterrupt();
-            else
-                B_timerinterrupt();
-        }
-        else
-        {
-            printf("INTERNAL PANIC: unknown event type \n");
-        }
-        free(eventptr);
-    }
-
-    terminate:
-    printf(
-            " Simulator terminated at time %f\n after sending %d msgs from layer5\n",
-            g_time, nsim);
-}
-
-void init(int argc, char **argv) /* initialize the simulator */
-{
-    int i;
-    float sum, avg;
-    float jimsrand();
-
-    if (argc != 6)
-    {
-        printf("usage: %s  num_sim  prob_loss  prob_corrupt  interval  debug_level\n", argv[0]);
-        exit(1);
-    }
-
-    nsimmax = atoi(argv[1]);
-    lossprob = atof(argv[2]);
-    corruptprob = atof(argv[3]);
-    lambda = atof(argv[4]);
-    TRACE = atoi(argv[5]);
-    printf("-----  Stop and Wait Network Simulator Version 1.1 -------- \n\n");
-    printf("the number of messages to simulate: %d\n", nsimmax);
-    printf("packet loss probability: %f\n", lossprob);
-    printf("packet corruption probability: %f\n", corruptprob);
-    printf("average time between messages from sender's layer5: %f\n", lambda);
-    printf("TRACE: %d\n", TRACE);
-
-    //srand((unsigned)time(NULL)); /* init random number generator */
-    srand(1);
-    sum = 0.0;   /* test random number generator for students */
-    for (i = 0; i < 1000; i++)
-        sum = sum + jimsrand(); /* jimsrand() should be uniform in [0,1] */
-    avg = sum / 1000.0;
-    if (avg < 0.25 || avg > 0.75)
-    {
-        printf("It is likely that random number generation on your machine\n");
-        printf("is different from what this emulator expects.  Please take\n");
-        printf("a look at the routine jimsrand() in the emulator code. Sorry. \n");
-        exit(1);
-    }
-
-    ntolayer3 = 0;
-    nlost = 0;
-    ncorrupt = 0;
-
-    g_time = 0.0;              /* initialize g_time to 0.0 */
-    generate_next_arrival(); /* initialize event list */
-}
-
-/****************************************************************************/
-/* jimsrand(): return a float in range [0,1].  The routine below is used to */
-/* isolate all random number generation in one location.  We assume that the*/
-/* system-supplied rand() function return an int in therange [0,mmm]        */
-/****************************************************************************/
-float jimsrand(void)
-{
-    double mmm = RAND_MAX;
-    float x;          /* individual students may need to change mmm */
-    x = rand() / mmm; /* x should be uniform in [0,1] */
-    return (x);
-}
-
-/********************* EVENT HANDLING ROUTINES *******/
-/*  The next set of routines handle the event list   */
-/*****************************************************/
-
-void generate_next_arrival(void)
-{
-    double x, log(), ceil();
-    struct event *evptr;
-    float ttime;
-    int tempint;
-
-    if (TRACE > 2)
-        printf("          GENERATE NEXT ARRIVAL: creating new arrival\n");
-
-    x = lambda * jimsrand() * 2; /* x is uniform on [0,2*lambda] */
-    /* having mean of lambda        */
-    evptr = (struct event *)malloc(sizeof(struct event));
-    evptr->evtime = g_time + x;
-    evptr->evtype = FROM_LAYER5;
-    if (BIDIRECTIONAL && (jimsrand() > 0.5))
-        evptr->eventity = B;
-    else
-        evptr->eventity = A;
-    insertevent(evptr);
-}
-
-void insertevent(struct event *p)
-{
-    struct event *q, *qold;
-
-    if (TRACE > 2)
-    {
-        printf("            INSERTEVENT: time is %lf\n", g_time);
-        printf("            INSERTEVENT: future time will be %lf\n", p->evtime);
-    }
-    q = evlist; /* q points to header of list in which p struct inserted */
-    if (q == NULL)
-    { /* list is empty */
-        evlist = p;
-        p->next = NULL;
-        p->prev = NULL;
-    }
-    else
-    {
-        for (qold = q; q != NULL && p->evtime > q->evtime; q = q->next)
-            qold = q;
-        if (q == NULL)
-        { /* end of list */
-            qold->next = p;
-            p->prev = qold;
-            p->next = NULL;
-        }
-        else if (q == evlist)
-        { /* front of list */
-            p->next = evlist;
-            p->prev = NULL;
-            p->next->prev = p;
-            evlist = p;
-        }
-        else
-        { /* middle of list */
-            p->next = q;
-            p->prev = q->prev;
-            q->prev->next = p;
-            q->prev = p;
-        }
-    }
-}
-
-void printevlist(void)
-{
-    struct event *q;
-    int i;
-    printf("--------------\nEvent List Follows:\n");
-    for (q = evlist; q != NULL; q = q->next)
-    {
-        printf("Event time: %f, type: %d entity: %d\n", q->evtime, q->evtype,
-               q->eventity);
-    }
-    printf("--------------\n");
-}
-
-/********************** Student-callable ROUTINES ***********************/
-
-/* called by students routine to cancel a previously-started timer */
-void stoptimer(int AorB /* A or B is trying to stop timer */)
-{
-    struct event *q, *qold;
-
-    if (TRACE > 2)
-        printf("          STOP TIMER: stopping timer at %f\n", g_time);
-    /* for (q=evlist; q!=NULL && q->next!=NULL; q = q->next)  */
-    for (q = evlist; q != NULL; q = q->next)
-        if ((q->evtype == TIMER_INTERRUPT && q->eventity == AorB))
-        {
-            /* remove this event */
-            if (q->next == NULL && q->prev == NULL)
-                evlist = NULL;        /* remove first and only event on list */
-            else if (q->next == NULL) /* end of list - there is one in front */
-                q->prev->next = NULL;
-            else if (q == evlist)
-            { /* front of list - there must be event after */
-                q->next->prev = NULL;
-                evlist = q->next;
-            }
-            else
-            { /* middle of list */
-                q->next->prev = q->prev;
-                q->prev->next = q->next;
-            }
-            free(q);
-            return;
-        }
-    printf("Warning: unable to cancel your timer. It wasn't running.\n");
-}
-
-void starttimer(int AorB /* A or B is trying to stop timer */, float increment)
-{
-    struct event *q;
-    struct event *evptr;
-
-    if (TRACE > 2)
-        printf("          START TIMER: starting timer at %f\n", g_time);
-    /* be nice: check to see if timer is already started, if so, then  warn */
-    /* for (q=evlist; q!=NULL && q->next!=NULL; q = q->next)  */
-    for (q = evlist; q != NULL; q = q->next)
-        if ((q->evtype == TIMER_INTERRUPT && q->eventity == AorB))
-        {
-            printf("Warning: attempt to start a timer that is already started\n");
-            return;
-        }
-
-    /* create future event for when timer goes off */
-    evptr = (struct event *)malloc(sizeof(struct event));
-    evptr->evtime = g_time + increment;
-    evptr->evtype = TIMER_INTERRUPT;
-    evptr->eventity = AorB;
-    insertevent(evptr);
-}
-
-/************************** TOLAYER3 ***************/
-void tolayer3(int AorB /* A or B is trying to stop timer */, struct pkt packet)
-{
-    struct pkt *mypktptr;
-    struct event *evptr, *q;
-    float lastime, x;
-    int i;
-
-    ntolayer3++;
-
-    /* simulate losses: */
-    if (jimsrand() < lossprob)
-    {
-        nlost++;
-        if (TRACE > 0)
-            printf("          TOLAYER3: packet being lost\n");
-        return;
-    }
-
-    /* make a copy of the packet student just gave me since he/she may decide */
-    /* to do something with the packet after we return back to him/her */
-    mypktptr = (struct pkt *)malloc(sizeof(struct pkt));
-    mypktptr->seqnum = packet.seqnum;
-    mypktptr->acknum = packet.acknum;
-    mypktptr->checksum = packet.checksum;
-    for (i = 0; i < 20; i++)
-        mypktptr->payload[i] = packet.payload[i];
-    if (TRACE > 2)
-    {
-        printf("          TOLAYER3: seq: %d, ack %d, check: %d ", mypktptr->seqnum,
-               mypktptr->acknum, mypktptr->checksum);
-        for (i = 0; i < 20; i++)
-            printf("%c", mypktptr->payload[i]);
-        printf("\n");
-    }
-
-    /* create future event for arrival of packet at the other side */
-    evptr = (struct event *)malloc(sizeof(struct event));
-    evptr->evtype = FROM_LAYER3;      /* packet will pop out from layer3 */
-    evptr->eventity = (AorB + 1) % 2; /* event occurs at other entity */
-    evptr->pktptr = mypktptr;         /* save ptr to my copy of packet */
-    /* finally, compute the arrival time of packet at the other end.
-       medium can not reorder, so make sure packet arrives between 1 and 10
-       time units after the latest arrival time of packets
-       currently in the medium on their way to the destination */
-    lastime = g_time;
-    /* for (q=evlist; q!=NULL && q->next!=NULL; q = q->next) */
-    for (q = evlist; q != NULL; q = q->next)
-        if ((q->evtype == FROM_LAYER3 && q->eventity == evptr->eventity))
-            lastime = q->evtime;
-    evptr->evtime = lastime + 1 + 9 * jimsrand();
-
-    /* simulate corruption: */
-    if (jimsrand() < corruptprob)
-    {
-        ncorrupt++;
-        if ((x = jimsrand()) < .75)
-            mypktptr->payload[0] = 'Z'; /* corrupt payload */
-        else if (x < .875)
-            mypktptr->seqnum = 999999;
-        else
-            mypktptr->acknum = 999999;
-        if (TRACE > 0)
-            printf("          TOLAYER3: packet being corrupted\n");
-    }
-
-    if (TRACE > 2)
-        printf("          TOLAYER3: scheduling arrival on other side\n");
-    insertevent(evptr);
-}
-
-void tolayer5(int AorB, char datasent[20])
-{
-    int i;
-    if (TRACE > 2)
-    {
-        printf("          TOLAYER5: data received: ");
-        for (i = 0; i < 20; i++)
-            printf("%c", datasent[i]);
-        printf("\n");
-    }
-}
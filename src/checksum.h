@@ -0,0 +1,25 @@
+#ifndef RDT_CHECKSUM_H
+#define RDT_CHECKSUM_H
+
+#include <stdint.h>
+
+/* selectable packet checksum.  A checksum is computed in two steps so
+   senders can keep the payload part of a packet they may have to send
+   again (or of the all-zero ACK payload) and only redo the header:
+
+       partial = cksum_payload(kind, payload, len);
+       packet.checksum = cksum_finish(kind, partial, seqnum, acknum); */
+
+#define CKSUM_SUM 0    /* legacy: seqnum + acknum + signed payload bytes */
+#define CKSUM_INET 1   /* RFC 1071 ones-complement sum of 16-bit words */
+#define CKSUM_CRC32C 2 /* Castagnoli CRC, SSE4.2 crc32 when available */
+#define CKSUM_NKINDS 3
+
+/* kind is one of the CKSUM_* engines above */
+uint32_t cksum_payload(int kind, const char *data, int len);
+int cksum_finish(int kind, uint32_t partial, int seqnum, int acknum);
+
+int cksum_parse(const char *name); /* -1 if name is unknown */
+const char *cksum_name(int kind);
+
+#endif
@@ -0,0 +1,1216 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <limits.h>
+
+#include "emulator.h"
+#include "checksum.h"
+#include "log.h"
+#include "pool.h"
+#include "runner.h"
+#include "trace.h"
+
+/*****************************************************************
+***************** NETWORK EMULATION CODE STARTS BELOW ***********
+The code below emulates the layer 3 and below network environment:
+    - emulates the transmission and delivery (possibly with bit-level corruption
+        and packet loss) of packets across the layer 3/4 interface
+    - handles the starting/stopping of a timer, and generates timer
+        interrupts (resulting in calling students timer handler).
+    - generates message to be sent (passed from later 5 to 4)
+THERE IS NOT REASON THAT ANY STUDENT SHOULD HAVE TO READ OR UNDERSTAND
+THE CODE BELOW.  YOU SHOULD NOT TOUCH, OR REFERENCE (in your code) ANY
+OF THE DATA STRUCTURES BELOW.  If you're interested in how I designed
+the emulator, you're welcome to look at the code - but again, you should have
+to, and you definitely should not have to modify
+******************************************************************/
+
+struct event
+{
+    float evtime;       /* event time */
+    int evtype;         /* event type code */
+    int eventity;       /* entity where event occurs */
+    struct pkt pkt;     /* packet (if any) carried by this event; its
+                           payload bytes follow the event in memory */
+    unsigned long evseq; /* insertion order, breaks ties on evtime */
+    int heapidx;         /* current slot of this event in evlist */
+};
+
+/* the event list (ctx->evlist) is a 4-ary min-heap on evtime.  Among
+   events with equal evtime the one inserted last is popped first, which
+   is the order the original sorted linked list produced (new events went
+   in front of existing ones with the same time), so seeded runs
+   reproduce exactly */
+#define EVHEAP_ARITY 4
+
+/* events are recycled through ctx->evpool rather than malloc'd and freed
+   one at a time.  Each one has room for a payload_size-byte payload */
+#define POOL_SLAB 256             /* events per slab ... */
+#define POOL_SLAB_BYTES (1 << 20) /* ... unless that's more than this */
+#define EVENT_PAYLOAD(ev) ((char *)((ev) + 1))
+
+/* possible events: */
+#define TIMER_INTERRUPT 0
+#define FROM_LAYER5 1
+#define FROM_LAYER3 2
+
+#define OFF 0
+#define ON 1
+
+/* what the command line asked for */
+struct options
+{
+    struct sim_config cfg;
+    const char *tracefile; /* --trace-file, or NULL */
+    int replications;      /* runs to do in batch mode, 0 for a single run */
+    unsigned seed;         /* --seed for a single run */
+    int stream;            /* --stream for a single run */
+    unsigned seedbase;     /* batch seed, see run_replications() */
+    int threads;           /* batch workers, 0 for one per CPU */
+    int metrics;           /* METRICS_* record to print for each run */
+};
+
+void init(int argc, char **argv, struct options *opt);
+void selftest(struct sim_ctx *ctx);
+void batch(const struct options *opt, struct tracer *tracer);
+void generate_next_arrival(struct sim_ctx *ctx);
+void insertevent(struct sim_ctx *ctx, struct event *p);
+struct event *popevent(struct sim_ctx *ctx);
+void removeevent(struct sim_ctx *ctx, struct event *p);
+float jimsrand(struct sim_ctx *ctx);
+long long geometric(struct sim_ctx *ctx, double p);
+
+int main(int argc, char **argv)
+{
+    struct options opt;
+    struct tracer *tracer = NULL;
+    struct sim_ctx *ctx;
+
+    init(argc, argv, &opt);
+    if (opt.tracefile != NULL)
+    {
+        tracer = trace_open(opt.tracefile);
+        if (tracer == NULL)
+        {
+            printf("cannot create trace file %s\n", opt.tracefile);
+            exit(1);
+        }
+        printf("binary trace: %s\n", opt.tracefile);
+    }
+    if (opt.replications > 0)
+    {
+        batch(&opt, tracer);
+        trace_close(tracer);
+        return 0;
+    }
+    ctx = sim_create(&opt.cfg, tracer);
+
+    //sim_seed(ctx, (unsigned)time(NULL), 0); /* init random number generator */
+    sim_seed(ctx, opt.seed, opt.stream);
+    if (opt.cfg.rng_kind == RNG_RAND)
+        selftest(ctx); /* only the platform's rand() ever failed it */
+    sim_run(ctx);
+    printf(
+            " Simulator terminated at time %f\n after sending %d msgs from layer5\n",
+            ctx->time, ctx->nsim);
+    LOG(ctx, LOG_EVENT, " event pool: %ld allocations, high-water %ld, %ld slabs\n",
+        ctx->evpool.nalloc, ctx->evpool.highwater, ctx->evpool.nslabs);
+    if (opt.metrics != METRICS_NONE)
+    {
+        struct sim_metrics m;
+
+        sim_metrics(ctx, &m);
+        metrics_header(opt.metrics);
+        metrics_print(opt.metrics, opt.seed, opt.stream, &m);
+    }
+    sim_destroy(ctx);
+    trace_close(tracer);
+    return 0;
+}
+
+/* a context ready for sim_seed() and sim_run().  tracer may be NULL */
+struct sim_ctx *sim_create(const struct sim_config *cfg, struct tracer *tracer)
+{
+    struct sim_ctx *ctx;
+    int perslab;
+
+    ctx = (struct sim_ctx *)calloc(1, sizeof(*ctx));
+    if (ctx == NULL)
+    {
+        printf("INTERNAL PANIC: out of memory for a simulation\n");
+        exit(1);
+    }
+    ctx->cfg = *cfg;
+    ctx->tracer = tracer;
+    perslab = POOL_SLAB_BYTES / (sizeof(struct event) + cfg->payload_size);
+    pool_init(&ctx->evpool, sizeof(struct event) + cfg->payload_size,
+              perslab < POOL_SLAB ? perslab : POOL_SLAB);
+    ctx->msgdata = (char *)malloc(cfg->payload_size);
+    ctx->latency = (struct hist *)malloc(sizeof(struct hist));
+    ctx->sendtime = (float *)malloc(sizeof(float) * SENDRING);
+    if (ctx->msgdata == NULL || ctx->latency == NULL || ctx->sendtime == NULL)
+    {
+        printf("INTERNAL PANIC: out of memory for a simulation\n");
+        exit(1);
+    }
+    sim_seed(ctx, 1, 0);
+    ctx->proto = proto_new(ctx);
+    return ctx;
+}
+
+void sim_destroy(struct sim_ctx *ctx)
+{
+    proto_free(ctx->proto);
+    pool_destroy(&ctx->evpool);
+    free(ctx->evlist);
+    free(ctx->msgdata);
+    free(ctx->latency);
+    free(ctx->sendtime);
+    free(ctx);
+}
+
+/* seed this context's random stream with substream stream of seed, see
+   rng_jump().  RNG_RAND has no substreams and ignores stream */
+void sim_seed(struct sim_ctx *ctx, unsigned seed, int stream)
+{
+    rng_seed(&ctx->rng, ctx->cfg.rng_kind, seed);
+    while (stream-- > 0)
+        rng_jump(&ctx->rng);
+}
+
+/* put the emulator back in its starting state, keeping pools and buffers */
+static void sim_reset(struct sim_ctx *ctx)
+{
+    struct event *p;
+
+    while ((p = popevent(ctx)) != NULL)
+        pool_put(&ctx->evpool, p);
+    ctx->evserial = 0;
+    ctx->timers[A] = ctx->timers[B] = NULL;
+    ctx->inflight[A] = ctx->inflight[B] = 0;
+
+    ctx->nsim = 0;
+    ctx->ntolayer3 = 0;
+    ctx->nlost = 0;
+    ctx->ncorrupt = 0;
+    ctx->ndata = 0;
+    ctx->ndatabytes = 0;
+    ctx->nacks = 0;
+    ctx->nretransmit = 0;
+    ctx->ntimeouts = 0;
+    ctx->ndelivered = 0;
+    ctx->ndup = 0;
+    ctx->nbad = 0;
+    ctx->window = 0;
+    ctx->window_max = 0;
+    ctx->window_since = 0.0;
+    ctx->window_area = 0.0;
+    ctx->busy_area = 0.0;
+    ctx->backlog = 0;
+    ctx->backlog_max = 0;
+    ctx->stalled = 0;
+    ctx->nstalls = 0;
+    hist_reset(ctx->latency);
+    ctx->nuntimed = 0;
+    /* a window on the link, and one resend of it queued behind */
+    rto_init(&ctx->rto, ctx->cfg.rto_kind, 2.0f * CHANNEL_MAX_DELAY * (ctx->cfg.window + 1));
+
+    ctx->time = 0.0;              /* initialize time to 0.0 */
+    generate_next_arrival(ctx); /* initialize event list */
+    if (ctx->cfg.channel == CHANNEL_GEOMETRIC)
+    {
+        ctx->lossgap = geometric(ctx, ctx->cfg.lossprob);
+        ctx->bitgap = geometric(ctx, ctx->cfg.corruptprob);
+    }
+}
+
+/* one complete simulation: reset, initialise both entities and run the
+   event loop until no events are left */
+void sim_run(struct sim_ctx *ctx)
+{
+    struct event *eventptr;
+    struct msg msg2give;
+
+    int i, j;
+
+    sim_reset(ctx);
+    A_init(ctx);
+    B_init(ctx);
+    while (1)
+    {
+        eventptr = popevent(ctx); /* get next event to simulate */
+        if (eventptr == NULL)
+            return;
+        if (log_enabled(ctx, LOG_EVENT))
+        {
+            printf("\nEVENT time: %f,", eventptr->evtime);
+            printf("  type: %d", eventptr->evtype);
+            if (eventptr->evtype == 0)
+                printf(", timerinterrupt  ");
+            else if (eventptr->evtype == 1)
+                printf(", fromlayer5 ");
+            else
+                printf(", fromlayer3 ");
+            printf(" entity: %d\n", eventptr->eventity);
+        }
+        ctx->time = eventptr->evtime; /* update time to next event time */
+        if (eventptr->evtype == FROM_LAYER3)
+            TRACE_REC(ctx->tracer, ctx->time, TR_EVENT, eventptr->evtype, eventptr->eventity,
+                      eventptr->pkt.seqnum, eventptr->pkt.acknum);
+        else
+            TRACE_REC(ctx->tracer, ctx->time, TR_EVENT, eventptr->evtype, eventptr->eventity,
+                      -1, -1);
+        if (eventptr->evtype == FROM_LAYER5)
+        {
+            if (ctx->cfg.high_water > 0 && ctx->backlog >= ctx->cfg.high_water)
+            {
+                /* backpressure: the message waits in layer 5, and so does
+                   the rest of the traffic, until sim_backlog() sees the
+                   sender drain */
+                LOG(ctx, LOG_DEBUG, "          MAINLOOP: %d messages queued, layer 5 paused\n",
+                    ctx->backlog);
+                ctx->stalled = 1;
+                ctx->nstalls++;
+            }
+            else if (ctx->nsim < ctx->cfg.nsimmax)
+            {
+                if (ctx->nsim + 1 < ctx->cfg.nsimmax)
+                    generate_next_arrival(ctx); /* set up future arrival */
+                /* fill in msg to give with string of same letter */
+                j = ctx->nsim % 26;
+                memset(ctx->msgdata, 97 + j, ctx->cfg.payload_size);
+                msg2give.data = ctx->msgdata;
+                msg2give.length = ctx->cfg.payload_size;
+                if (log_enabled(ctx, LOG_DEBUG))
+                {
+                    printf("          MAINLOOP: data given to student: ");
+                    for (i = 0; i < PREVIEW(ctx->cfg.payload_size); i++)
+                        printf("%c", msg2give.data[i]);
+                    printf("\n");
+                }
+                ctx->sendtime[ctx->nsim % SENDRING] = ctx->time;
+                ctx->nsim++;
+                if (eventptr->eventity == A)
+                    A_output(ctx, msg2give);
+                else
+                    B_output(ctx, msg2give);
+            }
+        }
+        else if (eventptr->evtype == FROM_LAYER3)
+        {
+            ctx->inflight[eventptr->eventity]--;
+            if (eventptr->eventity == A)        /* deliver packet by calling */
+                A_input(ctx, &eventptr->pkt);   /* appropriate entity */
+            else
+                B_input(ctx, &eventptr->pkt);
+        }
+        else if (eventptr->evtype == TIMER_INTERRUPT)
+        {
+            ctx->timers[eventptr->eventity] = NULL; /* handler may rearm it */
+            if (eventptr->eventity == A)
+                ctx->ntimeouts++;
+            if (eventptr->eventity == A)
+                A_timerinterrupt(ctx);
+            else
+                B_timerinterrupt(ctx);
+        }
+        else
+        {
+            printf("INTERNAL PANIC: unknown event type \n");
+        }
+        pool_put(&ctx->evpool, eventptr);
+    }
+}
+
+/* the summarised columns of a batch result line */
+#define BATCH_COLS 5
+static double batch_col(const struct rep_result *res, int k)
+{
+    switch (k)
+    {
+    case 0:
+        return res->m.time;
+    case 1:
+        return res->m.nsim;
+    case 2:
+        return res->m.packets;
+    case 3:
+        return res->m.lost;
+    default:
+        return res->m.corrupt;
+    }
+}
+
+/* batch mode: every replication starts from a clean emulator and
+   freshly initialised entities, one result line each, then the mean
+   and standard deviation of each column over all replications.  The
+   summary is accumulated in replication order once all of them are
+   done, so it comes out the same whatever the number of threads */
+void batch(const struct options *opt, struct tracer *tracer)
+{
+    struct rep_result *res;
+    struct hist *latency;
+    struct sim_metrics all;
+    double mean[BATCH_COLS], var[BATCH_COLS], d;
+    int n = opt->replications;
+    long nstolen;
+    int r, k;
+
+    res = (struct rep_result *)malloc(sizeof(struct rep_result) * n);
+    latency = (struct hist *)malloc(sizeof(struct hist));
+    if (res == NULL || latency == NULL)
+    {
+        printf("INTERNAL PANIC: out of memory for %d replications\n", n);
+        exit(1);
+    }
+    hist_reset(latency);
+    nstolen = run_replications(&opt->cfg, n, opt->seedbase, opt->threads, tracer, res,
+                               latency);
+    latency_metrics(latency, &all);
+
+    if (opt->metrics != METRICS_NONE)
+    {
+        /* a full record per replication instead of the table */
+        metrics_header(opt->metrics);
+        for (r = 0; r < n; r++)
+            metrics_print(opt->metrics, res[r].seed, res[r].stream, &res[r].m);
+        if (opt->metrics == METRICS_JSON)
+            printf("{\"protocol\": \"%s\", \"replications\": %d, \"delivered\": %llu, "
+                   "\"latency_mean\": %f, \"latency_p50\": %f, \"latency_p99\": %f, "
+                   "\"latency_p999\": %f, \"latency_max\": %f}\n",
+                   sim_name, n, (unsigned long long)latency->total, all.latency_mean,
+                   all.latency_p50, all.latency_p99, all.latency_p999, all.latency_max);
+        free(latency);
+        free(res);
+        return;
+    }
+    printf("rep,seed,time,msgs,tolayer3,lost,corrupt\n");
+    for (k = 0; k < BATCH_COLS; k++)
+        mean[k] = var[k] = 0.0;
+    for (r = 0; r < n; r++)
+    {
+        printf("%d,%u,%f,%d,%d,%d,%d\n", r, res[r].seed, res[r].m.time, res[r].m.nsim,
+               res[r].m.packets, res[r].m.lost, res[r].m.corrupt);
+        for (k = 0; k < BATCH_COLS; k++)
+            mean[k] += batch_col(&res[r], k);
+    }
+    for (k = 0; k < BATCH_COLS; k++)
+        mean[k] /= n;
+    for (r = 0; r < n; r++)
+        for (k = 0; k < BATCH_COLS; k++)
+        {
+            d = batch_col(&res[r], k) - mean[k];
+            var[k] += d * d;
+        }
+    printf("mean,");
+    for (k = 0; k < BATCH_COLS; k++)
+        printf(",%f", mean[k]);
+    printf("\nstddev,");
+    for (k = 0; k < BATCH_COLS; k++)
+        printf(",%f", n > 1 ? sqrt(var[k] / (n - 1)) : 0.0);
+    printf("\n");
+    /* percentiles of every message of every replication together */
+    printf("latency,,mean,p50,p99,p99.9,max\n");
+    printf("latency,,%f,%f,%f,%f,%f\n", all.latency_mean, all.latency_p50,
+           all.latency_p99, all.latency_p999, all.latency_max);
+    if (opt->cfg.trace >= LOG_INFO)
+        printf("%ld of %d replications stolen between workers\n", nstolen, n);
+    free(latency);
+    free(res);
+}
+
+/* the counters of a finished run, with the rates worked out */
+void sim_metrics(const struct sim_ctx *ctx, struct sim_metrics *m)
+{
+    double t = ctx->time;
+    double dt = ctx->time - ctx->window_since;
+
+    m->time = ctx->time;
+    m->nsim = ctx->nsim;
+    m->delivered = ctx->ndelivered;
+    m->duplicates = ctx->ndup;
+    m->bad = ctx->nbad;
+    m->packets = ctx->ntolayer3;
+    m->data = ctx->ndata;
+    m->retransmits = ctx->nretransmit;
+    m->acks = ctx->nacks;
+    m->lost = ctx->nlost;
+    m->corrupt = ctx->ncorrupt;
+    m->timeouts = ctx->ntimeouts;
+    m->window_max = ctx->window_max;
+    m->srtt = ctx->rto.srtt;
+    m->rttvar = ctx->rto.rttvar;
+    m->rto = rto_timeout(&ctx->rto);
+    m->rtt_samples = ctx->rto.nsamples;
+    m->backlog_max = ctx->backlog_max;
+    m->stalls = ctx->nstalls;
+    if (t > 0.0)
+    {
+        m->goodput = (double)ctx->ndelivered * ctx->cfg.payload_size / t;
+        m->throughput = ctx->ndatabytes / t;
+        m->window_mean = (ctx->window_area + ctx->window * dt) / t;
+        m->utilization = (ctx->busy_area + (ctx->window > 0 ? dt : 0.0)) / t;
+    }
+    else
+        m->goodput = m->throughput = m->window_mean = m->utilization = 0.0;
+    latency_metrics(ctx->latency, m);
+}
+
+/* the latency summary of h, which may merge many runs */
+void latency_metrics(const struct hist *h, struct sim_metrics *m)
+{
+    m->latency_mean = hist_mean(h);
+    m->latency_p50 = hist_percentile(h, 50.0);
+    m->latency_p99 = hist_percentile(h, 99.0);
+    m->latency_p999 = hist_percentile(h, 99.9);
+    m->latency_max = hist_max(h);
+}
+
+void metrics_header(int format)
+{
+    if (format == METRICS_CSV)
+        printf("protocol,seed,stream,time,msgs,delivered,duplicates,bad,packets,data,"
+               "retransmits,acks,lost,corrupt,timeouts,goodput,throughput,"
+               "window_mean,window_max,utilization,latency_mean,latency_p50,latency_p99,"
+               "latency_p999,latency_max,srtt,rttvar,rto,rtt_samples,backlog_max,stalls\n");
+}
+
+/* one record per run, on a line of its own */
+void metrics_print(int format, unsigned seed, int stream, const struct sim_metrics *m)
+{
+    if (format == METRICS_JSON)
+        printf("{\"protocol\": \"%s\", \"seed\": %u, \"stream\": %d, \"time\": %f, "
+               "\"msgs\": %d, \"delivered\": %d, \"duplicates\": %d, \"bad\": %d, "
+               "\"packets\": %d, \"data\": %d, \"retransmits\": %d, \"acks\": %d, "
+               "\"lost\": %d, \"corrupt\": %d, \"timeouts\": %d, \"goodput\": %f, "
+               "\"throughput\": %f, \"window_mean\": %f, \"window_max\": %d, "
+               "\"utilization\": %f, \"latency_mean\": %f, \"latency_p50\": %f, "
+               "\"latency_p99\": %f, \"latency_p999\": %f, \"latency_max\": %f, "
+               "\"srtt\": %f, \"rttvar\": %f, \"rto\": %f, \"rtt_samples\": %d, "
+               "\"backlog_max\": %d, \"stalls\": %d}\n",
+               sim_name, seed, stream, m->time, m->nsim, m->delivered, m->duplicates,
+               m->bad, m->packets, m->data, m->retransmits, m->acks, m->lost, m->corrupt,
+               m->timeouts, m->goodput, m->throughput, m->window_mean, m->window_max,
+               m->utilization, m->latency_mean, m->latency_p50, m->latency_p99,
+               m->latency_p999, m->latency_max, m->srtt, m->rttvar, m->rto, m->rtt_samples,
+               m->backlog_max, m->stalls);
+    else if (format == METRICS_CSV)
+        printf("%s,%u,%d,%f,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%f,%f,%f,%d,%f,%f,%f,%f,%f,%f,%f,%f,%f,%d,%d,%d\n",
+               sim_name, seed, stream, m->time, m->nsim, m->delivered, m->duplicates,
+               m->bad, m->packets, m->data, m->retransmits, m->acks, m->lost, m->corrupt,
+               m->timeouts, m->goodput, m->throughput, m->window_mean, m->window_max,
+               m->utilization, m->latency_mean, m->latency_p50, m->latency_p99,
+               m->latency_p999, m->latency_max, m->srtt, m->rttvar, m->rto, m->rtt_samples,
+               m->backlog_max, m->stalls);
+}
+
+void usage(const char *prog)
+{
+    printf("usage: %s  num_sim  prob_loss  prob_corrupt  interval  debug_level"
+           "  [--trace-file path] [--checksum sum|inet|crc32c] [--payload bytes]"
+           "  [--channel legacy|geometric] [--rto adaptive|fixed]"
+           "  [--ack-every k [--ack-delay time]] [--dup-acks n]"
+           "  [--window n] [--seq-space n] [--buffer n] [--high-water n]"
+           "  [--rng xoshiro|rand] [--seed seed [--stream k]]"
+           "  [--replications n [--seed-base seed] [--threads n]]"
+           "  [--metrics json|csv]\n", prog);
+    exit(1);
+}
+
+static const char *channel_names[] = {"legacy", "geometric"};
+
+static int channel_parse(const char *name)
+{
+    int k;
+
+    for (k = 0; k < (int)(sizeof(channel_names) / sizeof(channel_names[0])); k++)
+        if (strcmp(name, channel_names[k]) == 0)
+            return k;
+    return -1;
+}
+
+void init(int argc, char **argv, struct options *opt) /* parse the command line */
+{
+    struct sim_config *cfg = &opt->cfg;
+    int i;
+
+    if (argc < 6)
+        usage(argv[0]);
+    cfg->payload_size = DEFAULT_PAYLOAD;
+    cfg->cksum_kind = CKSUM_SUM;
+    cfg->rng_kind = RNG_XOSHIRO;
+    cfg->channel = CHANNEL_LEGACY;
+    cfg->rto_kind = RTO_ADAPTIVE;
+    cfg->ack_every = 1;
+    cfg->ack_delay = DEFAULT_ACK_DELAY;
+    cfg->dup_acks = DEFAULT_DUP_ACKS;
+    cfg->window = DEFAULT_WINDOW;
+    cfg->seq_space = 0;
+    cfg->buf_size = DEFAULT_BUF_SZ;
+    cfg->high_water = 0;
+    opt->seed = 1;
+    opt->stream = 0;
+    opt->tracefile = NULL;
+    opt->replications = 0;
+    opt->seedbase = 1;
+    opt->threads = 1;
+    opt->metrics = METRICS_NONE;
+    for (i = 6; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--trace-file") == 0 && i + 1 < argc)
+            opt->tracefile = argv[++i];
+        else if (strcmp(argv[i], "--checksum") == 0 && i + 1 < argc &&
+                 cksum_parse(argv[i + 1]) >= 0)
+            cfg->cksum_kind = cksum_parse(argv[++i]);
+        else if (strcmp(argv[i], "--channel") == 0 && i + 1 < argc &&
+                 channel_parse(argv[i + 1]) >= 0)
+            cfg->channel = channel_parse(argv[++i]);
+        else if (strcmp(argv[i], "--rto") == 0 && i + 1 < argc &&
+                 rto_parse(argv[i + 1]) >= 0)
+            cfg->rto_kind = rto_parse(argv[++i]);
+        else if (strcmp(argv[i], "--ack-every") == 0 && i + 1 < argc)
+        {
+            cfg->ack_every = atoi(argv[++i]);
+            if (cfg->ack_every < 1)
+                usage(argv[0]);
+        }
+        else if (strcmp(argv[i], "--ack-delay") == 0 && i + 1 < argc)
+        {
+            cfg->ack_delay = atof(argv[++i]);
+            if (cfg->ack_delay <= 0.0)
+                usage(argv[0]);
+        }
+        else if (strcmp(argv[i], "--dup-acks") == 0 && i + 1 < argc)
+        {
+            cfg->dup_acks = atoi(argv[++i]);
+            if (cfg->dup_acks < 0)
+                usage(argv[0]);
+        }
+        else if (strcmp(argv[i], "--window") == 0 && i + 1 < argc)
+        {
+            cfg->window = atoi(argv[++i]);
+            if (cfg->window < 1)
+                usage(argv[0]);
+        }
+        else if (strcmp(argv[i], "--seq-space") == 0 && i + 1 < argc)
+            cfg->seq_space = (uint32_t)strtoul(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--buffer") == 0 && i + 1 < argc)
+        {
+            cfg->buf_size = atoi(argv[++i]);
+            if (cfg->buf_size < 2)
+                usage(argv[0]);
+        }
+        else if (strcmp(argv[i], "--high-water") == 0 && i + 1 < argc)
+        {
+            cfg->high_water = atoi(argv[++i]);
+            if (cfg->high_water < 0)
+                usage(argv[0]);
+        }
+        else if (strcmp(argv[i], "--metrics") == 0 && i + 1 < argc &&
+                 strcmp(argv[i + 1], "json") == 0)
+        {
+            opt->metrics = METRICS_JSON;
+            i++;
+        }
+        else if (strcmp(argv[i], "--metrics") == 0 && i + 1 < argc &&
+                 strcmp(argv[i + 1], "csv") == 0)
+        {
+            opt->metrics = METRICS_CSV;
+            i++;
+        }
+        else if (strcmp(argv[i], "--rng") == 0 && i + 1 < argc &&
+                 rng_parse(argv[i + 1]) >= 0)
+            cfg->rng_kind = rng_parse(argv[++i]);
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+            opt->seed = (unsigned)strtoul(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--stream") == 0 && i + 1 < argc)
+        {
+            opt->stream = atoi(argv[++i]);
+            if (opt->stream < 0)
+                usage(argv[0]);
+        }
+        else if (strcmp(argv[i], "--payload") == 0 && i + 1 < argc)
+        {
+            cfg->payload_size = atoi(argv[++i]);
+            if (cfg->payload_size < 1 || cfg->payload_size > MAX_PAYLOAD)
+                usage(argv[0]);
+        }
+        else if (strcmp(argv[i], "--replications") == 0 && i + 1 < argc)
+        {
+            opt->replications = atoi(argv[++i]);
+            if (opt->replications < 1)
+                usage(argv[0]);
+        }
+        else if (strcmp(argv[i], "--seed-base") == 0 && i + 1 < argc)
+            opt->seedbase = (unsigned)strtoul(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+        {
+            opt->threads = atoi(argv[++i]);
+            if (opt->threads < 0)
+                usage(argv[0]);
+        }
+        else
+            usage(argv[0]);
+    }
+
+    cfg->nsimmax = atoi(argv[1]);
+    cfg->lossprob = atof(argv[2]);
+    cfg->corruptprob = atof(argv[3]);
+    cfg->lambda = atof(argv[4]);
+    cfg->trace = atoi(argv[5]);
+    printf("-----  %s Network Simulator Version 1.1 -------- \n\n", sim_name);
+    printf("the number of messages to simulate: %d\n", cfg->nsimmax);
+    printf("packet loss probability: %f\n", cfg->lossprob);
+    printf("channel: %s\n", channel_names[cfg->channel]);
+    if (cfg->channel == CHANNEL_GEOMETRIC)
+        printf("bit error rate: %g\n", cfg->corruptprob);
+    else
+        printf("packet corruption probability: %f\n", cfg->corruptprob);
+    printf("average time between messages from sender's layer5: %f\n", cfg->lambda);
+    printf("TRACE: %d\n", cfg->trace);
+    printf("checksum: %s\n", cksum_name(cfg->cksum_kind));
+    printf("payload size: %d\n", cfg->payload_size);
+    printf("retransmission timeout: %s\n", rto_name(cfg->rto_kind));
+    if (cfg->ack_every > 1)
+        printf("delayed ACKs: every %d packets, at most %f later\n", cfg->ack_every,
+               cfg->ack_delay);
+    if (cfg->window != DEFAULT_WINDOW || cfg->seq_space != 0)
+    {
+        if (cfg->seq_space == 0)
+            printf("window: %d, sequence space: 2^32\n", cfg->window);
+        else
+            printf("window: %d, sequence space: %u\n", cfg->window, cfg->seq_space);
+    }
+    if (cfg->high_water > 0)
+        printf("backpressure: layer 5 pauses at %d queued messages\n", cfg->high_water);
+    if (opt->replications == 0)
+        printf("random numbers: %s, seed %u, stream %d\n", rng_name(cfg->rng_kind),
+               opt->seed, opt->stream);
+    else
+    {
+        printf("random numbers: %s\n", rng_name(cfg->rng_kind));
+        if (cfg->rng_kind == RNG_RAND)
+            printf("replications: %d, seeds %u..%u", opt->replications, opt->seedbase,
+                   opt->seedbase + opt->replications - 1);
+        else
+            printf("replications: %d, seed %u, streams 0..%d", opt->replications,
+                   opt->seedbase, opt->replications - 1);
+        printf(", threads: %d\n", opt->threads > 0 ? opt->threads : runner_cpus());
+        /* the workers would interleave their records in one trace */
+        if (opt->tracefile != NULL && opt->threads != 1)
+        {
+            printf("--trace-file needs --threads 1\n");
+            exit(1);
+        }
+    }
+}
+
+/* test random number generator for students */
+void selftest(struct sim_ctx *ctx)
+{
+    float sum, avg;
+    int i;
+
+    sum = 0.0;
+    for (i = 0; i < 1000; i++)
+        sum = sum + jimsrand(ctx); /* jimsrand() should be uniform in [0,1] */
+    avg = sum / 1000.0;
+    if (avg < 0.25 || avg > 0.75)
+    {
+        printf("It is likely that random number generation on your machine\n");
+        printf("is different from what this emulator expects.  Please take\n");
+        printf("a look at the routine jimsrand() in the emulator code. Sorry. \n");
+        exit(1);
+    }
+}
+
+/****************************************************************************/
+/* jimsrand(): return a float in range [0,1].  The routine below is used to */
+/* isolate all random number generation in one location.  It draws from    */
+/* the context's own generator, see rng.h                                   */
+/****************************************************************************/
+float jimsrand(struct sim_ctx *ctx)
+{
+    float x;
+    x = rng_uniform(&ctx->rng); /* x should be uniform in [0,1] */
+    return (x);
+}
+
+/********************* EVENT HANDLING ROUTINES *******/
+/*  The next set of routines handle the event list   */
+/*****************************************************/
+
+void generate_next_arrival(struct sim_ctx *ctx)
+{
+    double x, log(), ceil();
+    struct event *evptr;
+    float ttime;
+    int tempint;
+
+    LOG(ctx, LOG_DEBUG, "          GENERATE NEXT ARRIVAL: creating new arrival\n");
+
+    x = ctx->cfg.lambda * jimsrand(ctx) * 2; /* x is uniform on [0,2*lambda] */
+    /* having mean of lambda        */
+    evptr = (struct event *)pool_get(&ctx->evpool);
+    evptr->evtime = ctx->time + x;
+    evptr->evtype = FROM_LAYER5;
+    if (BIDIRECTIONAL && (jimsrand(ctx) > 0.5))
+        evptr->eventity = B;
+    else
+        evptr->eventity = A;
+    insertevent(ctx, evptr);
+}
+
+/* is event a due before event b? */
+static int evbefore(const struct event *a, const struct event *b)
+{
+    if (a->evtime != b->evtime)
+        return a->evtime < b->evtime;
+    return a->evseq > b->evseq;
+}
+
+static void evplace(struct sim_ctx *ctx, struct event *p, int i)
+{
+    ctx->evlist[i] = p;
+    p->heapidx = i;
+}
+
+static void evsiftup(struct sim_ctx *ctx, int i)
+{
+    struct event *p = ctx->evlist[i];
+    int parent;
+
+    while (i > 0)
+    {
+        parent = (i - 1) / EVHEAP_ARITY;
+        if (!evbefore(p, ctx->evlist[parent]))
+            break;
+        evplace(ctx, ctx->evlist[parent], i);
+        i = parent;
+    }
+    evplace(ctx, p, i);
+}
+
+static void evsiftdown(struct sim_ctx *ctx, int i)
+{
+    struct event *p = ctx->evlist[i];
+    int child, best, k;
+
+    for (;;)
+    {
+        child = i * EVHEAP_ARITY + 1;
+        if (child >= ctx->evcount)
+            break;
+        best = child;
+        for (k = child + 1; k < child + EVHEAP_ARITY && k < ctx->evcount; k++)
+            if (evbefore(ctx->evlist[k], ctx->evlist[best]))
+                best = k;
+        if (!evbefore(ctx->evlist[best], p))
+            break;
+        evplace(ctx, ctx->evlist[best], i);
+        i = best;
+    }
+    evplace(ctx, p, i);
+}
+
+void insertevent(struct sim_ctx *ctx, struct event *p)
+{
+    LOG(ctx, LOG_DEBUG, "            INSERTEVENT: time is %lf\n", ctx->time);
+    LOG(ctx, LOG_DEBUG, "            INSERTEVENT: future time will be %lf\n", p->evtime);
+    if (ctx->evcount == ctx->evcapacity)
+    {
+        ctx->evcapacity = ctx->evcapacity ? 2 * ctx->evcapacity : 64;
+        ctx->evlist = (struct event **)realloc(ctx->evlist, sizeof(struct event *) * ctx->evcapacity);
+        if (ctx->evlist == NULL)
+        {
+            printf("INTERNAL PANIC: out of memory for the event list\n");
+            exit(1);
+        }
+    }
+    p->evseq = ctx->evserial++;
+    evplace(ctx, p, ctx->evcount++);
+    evsiftup(ctx, p->heapidx);
+}
+
+/* remove and return the earliest event, NULL if the list is empty */
+struct event *popevent(struct sim_ctx *ctx)
+{
+    struct event *p;
+
+    if (ctx->evcount == 0)
+        return NULL;
+    p = ctx->evlist[0];
+    removeevent(ctx, p);
+    return p;
+}
+
+/* unlink an event that is currently in the list */
+void removeevent(struct sim_ctx *ctx, struct event *p)
+{
+    int i = p->heapidx;
+    struct event *last = ctx->evlist[--ctx->evcount];
+
+    if (last == p)
+        return;
+    evplace(ctx, last, i);
+    if (i > 0 && evbefore(last, ctx->evlist[(i - 1) / EVHEAP_ARITY]))
+        evsiftup(ctx, i);
+    else
+        evsiftdown(ctx, i);
+}
+
+void printevlist(struct sim_ctx *ctx)
+{
+    struct event *q;
+    int i;
+    printf("--------------\nEvent List Follows (heap order):\n");
+    for (i = 0; i < ctx->evcount; i++)
+    {
+        q = ctx->evlist[i];
+        printf("Event time: %f, type: %d entity: %d\n", q->evtime, q->evtype,
+               q->eventity);
+    }
+    printf("--------------\n");
+}
+
+/********************** Student-callable ROUTINES ***********************/
+
+/* called by students routine to cancel a previously-started timer */
+void stoptimer(struct sim_ctx *ctx, int AorB /* A or B is trying to stop timer */)
+{
+    struct event *q;
+
+    LOG(ctx, LOG_DEBUG, "          STOP TIMER: stopping timer at %f\n", ctx->time);
+    q = ctx->timers[AorB];
+    if (q == NULL)
+    {
+        LOG(ctx, LOG_WARN, "Warning: unable to cancel your timer. It wasn't running.\n");
+        return;
+    }
+    TRACE_REC(ctx->tracer, ctx->time, TR_TIMER_STOP, TIMER_INTERRUPT, AorB, -1, -1);
+    /* remove this event */
+    removeevent(ctx, q);
+    ctx->timers[AorB] = NULL;
+    pool_put(&ctx->evpool, q);
+}
+
+void starttimer(struct sim_ctx *ctx, int AorB /* A or B is trying to stop timer */, float increment)
+{
+    struct event *evptr;
+
+    LOG(ctx, LOG_DEBUG, "          START TIMER: starting timer at %f\n", ctx->time);
+    /* be nice: check to see if timer is already started, if so, then  warn */
+    if (ctx->timers[AorB] != NULL)
+    {
+        LOG(ctx, LOG_WARN, "Warning: attempt to start a timer that is already started\n");
+        return;
+    }
+
+    /* create future event for when timer goes off */
+    evptr = (struct event *)pool_get(&ctx->evpool);
+    evptr->evtime = ctx->time + increment;
+    evptr->evtype = TIMER_INTERRUPT;
+    evptr->eventity = AorB;
+    insertevent(ctx, evptr);
+    ctx->timers[AorB] = evptr;
+    TRACE_REC(ctx->tracer, ctx->time, TR_TIMER_START, TIMER_INTERRUPT, AorB, -1, -1);
+}
+
+/* same as stoptimer() followed by starttimer(), but moves the pending
+   timer event in place instead of freeing and reallocating it.  Starts
+   the timer if it wasn't running */
+void restarttimer(struct sim_ctx *ctx, int AorB /* A or B is trying to restart timer */, float increment)
+{
+    struct event *q;
+
+    LOG(ctx, LOG_DEBUG, "          RESTART TIMER: restarting timer at %f\n", ctx->time);
+    q = ctx->timers[AorB];
+    if (q == NULL)
+    {
+        starttimer(ctx, AorB, increment);
+        return;
+    }
+    removeevent(ctx, q);
+    q->evtime = ctx->time + increment;
+    insertevent(ctx, q); /* re-queued as the newest event, like a fresh start */
+    TRACE_REC(ctx->tracer, ctx->time, TR_TIMER_RESTART, TIMER_INTERRUPT, AorB, -1, -1);
+}
+
+/************************** CHANNEL ERRORS ***************/
+
+/* CHANNEL_GEOMETRIC never draws per packet.  Losses are Bernoulli(lossprob)
+   per packet and bit errors Bernoulli(ber) per bit, so the gap to the
+   next one is geometric: draw it once, count it down, and only spend
+   random numbers on the packets it hits */
+
+#define GAP_NEVER (LLONG_MAX / 2) /* gap when p is 0; never counted down to 0 */
+#define CHANNEL_HDR 12            /* seqnum, acknum and checksum are exposed */
+
+/* failures before the next success of a Bernoulli(p) trial */
+long long geometric(struct sim_ctx *ctx, double p)
+{
+    double g;
+
+    if (p <= 0.0)
+        return GAP_NEVER;
+    if (p >= 1.0)
+        return 0;
+    g = floor(log(rng_uniform(&ctx->rng)) / log1p(-p));
+    return g < (double)GAP_NEVER ? (long long)g : GAP_NEVER;
+}
+
+/* flip bit b of the packet as it crosses the medium: the three header
+   words, then the payload.  length stays intact so the copy is safe */
+static void flipbit(struct pkt *packet, long long b)
+{
+    unsigned *hdr[3];
+    int byte = (int)(b / 8);
+
+    if (byte < CHANNEL_HDR)
+    {
+        hdr[0] = (unsigned *)&packet->seqnum;
+        hdr[1] = (unsigned *)&packet->acknum;
+        hdr[2] = (unsigned *)&packet->checksum;
+        *hdr[b / 32] ^= 1u << (b % 32);
+    }
+    else
+        packet->payload[byte - CHANNEL_HDR] ^= (char)(1 << (b % 8));
+}
+
+/* apply the bit errors due in this packet, returns how many */
+static int biterrors(struct sim_ctx *ctx, struct pkt *packet)
+{
+    long long nbits = 8LL * (CHANNEL_HDR + packet->length);
+    long long b;
+    int nflips = 0;
+
+    if (ctx->bitgap >= nbits)
+    {
+        ctx->bitgap -= nbits;
+        return 0;
+    }
+    for (b = ctx->bitgap; b < nbits; b += 1 + geometric(ctx, ctx->cfg.corruptprob))
+    {
+        flipbit(packet, b);
+        nflips++;
+    }
+    ctx->bitgap = b - nbits;
+    return nflips;
+}
+
+/************************** TOLAYER3 ***************/
+void tolayer3(struct sim_ctx *ctx, int AorB /* A or B is trying to stop timer */, const struct pkt *packet)
+{
+    struct pkt *mypktptr;
+    struct event *evptr;
+    float lastime, x;
+    int i;
+
+    ctx->ntolayer3++;
+    if (AorB == A) /* transfer is simplex, A to B */
+    {
+        ctx->ndata++;
+        ctx->ndatabytes += packet->length;
+    }
+    else
+        ctx->nacks++;
+    TRACE_REC(ctx->tracer, ctx->time, TR_SEND, FROM_LAYER3, AorB, packet->seqnum, packet->acknum);
+
+    /* simulate losses: */
+    if (ctx->cfg.channel == CHANNEL_GEOMETRIC ? ctx->lossgap-- == 0
+                                              : jimsrand(ctx) < ctx->cfg.lossprob)
+    {
+        if (ctx->cfg.channel == CHANNEL_GEOMETRIC)
+            ctx->lossgap = geometric(ctx, ctx->cfg.lossprob);
+        ctx->nlost++;
+        TRACE_REC(ctx->tracer, ctx->time, TR_LOST, FROM_LAYER3, AorB, packet->seqnum, packet->acknum);
+        LOG(ctx, LOG_INFO, "          TOLAYER3: packet being lost\n");
+        return;
+    }
+
+    /* make a copy of the packet student just gave me since he/she may decide */
+    /* to do something with the packet after we return back to him/her.  The */
+    /* copy lives inside the arrival event and is handed over by pointer */
+    if (packet->length < 0 || packet->length > ctx->cfg.payload_size)
+    {
+        printf("INTERNAL PANIC: packet length %d exceeds payload size %d\n",
+               packet->length, ctx->cfg.payload_size);
+        exit(1);
+    }
+    evptr = (struct event *)pool_get(&ctx->evpool);
+    evptr->pkt = *packet;
+    mypktptr = &evptr->pkt;
+    mypktptr->payload = EVENT_PAYLOAD(evptr);
+    if (packet->length > 0)
+        memcpy(mypktptr->payload, packet->payload, packet->length);
+    if (log_enabled(ctx, LOG_DEBUG))
+    {
+        printf("          TOLAYER3: seq: %d, ack %d, check: %d ", mypktptr->seqnum,
+               mypktptr->acknum, mypktptr->checksum);
+        for (i = 0; i < PREVIEW(mypktptr->length); i++)
+            printf("%c", mypktptr->payload[i]);
+        printf("\n");
+    }
+
+    /* fill in the future event for arrival of packet at the other side */
+    evptr->evtype = FROM_LAYER3;      /* packet will pop out from layer3 */
+    evptr->eventity = (AorB + 1) % 2; /* event occurs at other entity */
+    /* finally, compute the arrival time of packet at the other end.
+       medium can not reorder, so make sure packet arrives between 1 and 10
+       time units after the latest arrival time of packets
+       currently in the medium on their way to the destination */
+    lastime = ctx->time;
+    if (ctx->inflight[evptr->eventity] > 0) /* each arrival is later than the last */
+        lastime = ctx->lastarrival[evptr->eventity];
+    evptr->evtime = lastime + 1 + (CHANNEL_MAX_DELAY - 1) * jimsrand(ctx);
+    ctx->inflight[evptr->eventity]++;
+    ctx->lastarrival[evptr->eventity] = evptr->evtime;
+
+    /* simulate corruption: */
+    if (ctx->cfg.channel == CHANNEL_GEOMETRIC)
+    {
+        if ((i = biterrors(ctx, mypktptr)) > 0)
+        {
+            ctx->ncorrupt++;
+            LOG(ctx, LOG_INFO, "          TOLAYER3: packet being corrupted (%d bits)\n", i);
+            TRACE_REC(ctx->tracer, ctx->time, TR_CORRUPT, FROM_LAYER3, evptr->eventity,
+                      mypktptr->seqnum, mypktptr->acknum);
+        }
+    }
+    else if (jimsrand(ctx) < ctx->cfg.corruptprob)
+    {
+        ctx->ncorrupt++;
+        if ((x = jimsrand(ctx)) < .75)
+        {
+            if (mypktptr->length > 0)
+                mypktptr->payload[0] = 'Z'; /* corrupt payload */
+            else
+                mypktptr->checksum ^= 1; /* no payload, hit the checksum */
+        }
+        else if (x < .875)
+            mypktptr->seqnum = 999999;
+        else
+            mypktptr->acknum = 999999;
+        LOG(ctx, LOG_INFO, "          TOLAYER3: packet being corrupted\n");
+        TRACE_REC(ctx->tracer, ctx->time, TR_CORRUPT, FROM_LAYER3, evptr->eventity,
+                  mypktptr->seqnum, mypktptr->acknum);
+    }
+
+    LOG(ctx, LOG_DEBUG, "          TOLAYER3: scheduling arrival on other side\n");
+    insertevent(ctx, evptr);
+}
+
+void tolayer5(struct sim_ctx *ctx, int AorB, const char *datasent, int length)
+{
+    int i;
+    TRACE_REC(ctx->tracer, ctx->time, TR_DELIVER, FROM_LAYER3, AorB, -1, -1);
+    /* message k is all 'a' + k % 26, so the first byte tells whether this
+       is the next message, the last one again or something else */
+    if (length > 0)
+    {
+        if (datasent[0] == 'a' + ctx->ndelivered % 26)
+        {
+            if (ctx->nsim - ctx->ndelivered <= SENDRING)
+                hist_record(ctx->latency, ctx->time - ctx->sendtime[ctx->ndelivered % SENDRING]);
+            else
+                ctx->nuntimed++;
+            ctx->ndelivered++;
+        }
+        else if (ctx->ndelivered > 0 && datasent[0] == 'a' + (ctx->ndelivered - 1) % 26)
+            ctx->ndup++;
+        else
+            ctx->nbad++;
+    }
+    if (log_enabled(ctx, LOG_DEBUG))
+    {
+        printf("          TOLAYER5: data received: ");
+        for (i = 0; i < PREVIEW(length); i++)
+            printf("%c", datasent[i]);
+        printf("\n");
+    }
+}
+
+void sim_retransmit(struct sim_ctx *ctx)
+{
+    ctx->nretransmit++;
+}
+
+/* the sender has outstanding packets unacknowledged from now on */
+void sim_window(struct sim_ctx *ctx, int outstanding)
+{
+    float dt = ctx->time - ctx->window_since;
+
+    ctx->window_area += (double)ctx->window * dt;
+    if (ctx->window > 0)
+        ctx->busy_area += dt;
+    ctx->window = outstanding;
+    ctx->window_since = ctx->time;
+    if (outstanding > ctx->window_max)
+        ctx->window_max = outstanding;
+}
+
+/* the sender holds queued messages it has not sent yet.  Below the high
+   water mark again, an arrival held back by backpressure goes ahead now */
+void sim_backlog(struct sim_ctx *ctx, int queued)
+{
+    struct event *evptr;
+
+    ctx->backlog = queued;
+    if (queued > ctx->backlog_max)
+        ctx->backlog_max = queued;
+    if (ctx->stalled && queued < ctx->cfg.high_water)
+    {
+        ctx->stalled = 0;
+        evptr = (struct event *)pool_get(&ctx->evpool);
+        evptr->evtime = ctx->time;
+        evptr->evtype = FROM_LAYER5;
+        evptr->eventity = A;
+        insertevent(ctx, evptr);
+    }
+}
+
+void *ring_grow(void *ring, size_t size, int cap, int start, int count)
+{
+    int first = cap - start < count ? cap - start : count;
+    char *grown = (char *)malloc(2 * (size_t)cap * size);
+
+    if (grown == NULL)
+    {
+        printf("INTERNAL PANIC: out of memory for %d queued messages\n", count);
+        exit(1);
+    }
+    memcpy(grown, (const char *)ring + (size_t)start * size, (size_t)first * size);
+    memcpy(grown + (size_t)first * size, ring, (size_t)(count - first) * size);
+    free(ring);
+    return grown;
+}
+
+uint32_t seq_next(struct sim_ctx *ctx, uint32_t seqnum, uint32_t shift)
+{
+    uint32_t space = ctx->cfg.seq_space;
+
+    return space ? (uint32_t)(((uint64_t)seqnum + shift) % space) : seqnum + shift;
+}
+
+uint32_t seq_prev(struct sim_ctx *ctx, uint32_t seqnum)
+{
+    return seq_next(ctx, seqnum, ctx->cfg.seq_space - 1);
+}
+
+uint32_t seq_offset(struct sim_ctx *ctx, uint32_t seqnum, uint32_t base)
+{
+    uint32_t space = ctx->cfg.seq_space;
+
+    return space ? (uint32_t)(((uint64_t)seqnum % space + space - base) % space) : seqnum - base;
+}
+
+void window_check(struct sim_ctx *ctx)
+{
+    long queued = (long)ctx->cfg.window * CHANNEL_MAX_DELAY;
+
+    if (queued > RTO_MAX)
+        printf("%s: warning: a window of %d may queue for %ld time units, longer than "
+               "the largest timeout (%.0f)\n", sim_name, ctx->cfg.window, queued, RTO_MAX);
+}
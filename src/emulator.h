@@ -0,0 +1,253 @@
+#ifndef RDT_EMULATOR_H
+#define RDT_EMULATOR_H
+
+/* ******************************************************************
+ ALTERNATING BIT AND GO-BACK-N NETWORK EMULATOR: VERSION 1.1  J.F.Kurose
+
+   This code should be used for PA2, unidirectional or bidirectional
+   data transfer protocols (from A to B. Bidirectional transfer of data
+   is for extra credit and is not required).  Network properties:
+   - one way network delay averages five time units (longer if there
+       are other messages in the channel for GBN), but can be larger
+   - packets can be corrupted (either the header or the data portion)
+       or lost, according to user-defined probabilities
+   - packets will be delivered in the order in which they were sent
+       (although some can be lost).
+
+   The emulator itself lives in emulator.c and is shared by altBit,
+   goBackN and selectiveRepeat; each of those only supplies the A/B
+   entity routines declared at the bottom of this file.
+**********************************************************************/
+
+#define BIDIRECTIONAL 0 /* change to 1 if you're doing extra credit */
+/* and write a routine called B_output */
+
+#define A 0
+#define B 1
+
+#include "hist.h"
+#include "pool.h"
+#include "rng.h"
+#include "rto.h"
+
+/* a "msg" is the data unit passed from layer 5 (teachers code) to layer  */
+/* 4 (students' code).  It contains the data (characters) to be delivered */
+/* to layer 5 via the students transport level protocol entities.         */
+struct msg
+{
+    int length; /* bytes in data, always payload_size */
+    char *data; /* owned by the emulator, copy it to keep it */
+};
+
+/* a packet is the data unit passed from layer 4 (students code) to layer */
+/* 3 (teachers code).  Note the pre-defined packet structure, which all   */
+/* students must follow. */
+struct pkt
+{
+    int seqnum;
+    int acknum;
+    int checksum;
+    int length;    /* bytes in payload, 0 to payload_size */
+    char *payload; /* tolayer3() copies what this points at */
+};
+
+/* payload bytes per message, set with --payload (default 20) */
+#define DEFAULT_PAYLOAD 20
+#define MAX_PAYLOAD 65536
+
+/* delayed ACKs, see --ack-every and --ack-delay */
+#define DEFAULT_ACK_DELAY 10.0f
+
+/* goBackN fast retransmit, see --dup-acks */
+#define DEFAULT_DUP_ACKS 3
+
+/* sliding windows of goBackN and selectiveRepeat, see --window */
+#define DEFAULT_WINDOW 10
+
+/* slots a sender's queue starts with, it grows as needed, see --buffer */
+#define DEFAULT_BUF_SZ 64
+
+/* channel error models, see --channel */
+#define CHANNEL_LEGACY 0    /* per-packet loss and corruption draws */
+#define CHANNEL_GEOMETRIC 1 /* skip-ahead loss gaps, bit errors at a BER */
+
+/* a packet arrives 1 to CHANNEL_MAX_DELAY time units after the one ahead
+   of it on the link, so n packets in flight may take n times that */
+#define CHANNEL_MAX_DELAY 10
+
+/* run parameters from the command line, fixed for the whole run */
+struct sim_config
+{
+    int nsimmax;       /* number of msgs to generate, then stop */
+    float lossprob;    /* probability that a packet is dropped */
+    float corruptprob; /* probability that one bit is packet is flipped, or
+                          the bit error rate with CHANNEL_GEOMETRIC */
+    float lambda;      /* arrival rate of messages from layer 5 */
+    int trace;         /* TRACE level, see log.h */
+    int payload_size;  /* payload bytes per message */
+    int cksum_kind;    /* CKSUM_* engine, see checksum.h */
+    int rng_kind;      /* RNG_* generator, see rng.h */
+    int channel;       /* CHANNEL_* error model */
+    int rto_kind;      /* RTO_* retransmission timeout, see rto.h */
+    int ack_every;     /* receiver ACKs every ack_every in-order packets ... */
+    float ack_delay;   /* ... or this long after the first unacked one */
+    int dup_acks;      /* duplicate ACKs that trigger a fast retransmit, 0 never */
+    int window;        /* packets the sender may have outstanding */
+    uint32_t seq_space; /* seqnums run over [0, seq_space), 0 for all of 2^32 */
+    int buf_size;      /* messages the sender's queue holds before it grows */
+    int high_water;    /* unsent messages that pause layer 5, 0 never */
+};
+
+struct event;
+struct tracer;
+struct proto_state; /* defined by each protocol */
+
+/* one simulation.  Everything a run changes lives here, so independent
+   simulations can share a process as long as each has its own context.
+   The entity routines only need cfg, proto and time; the rest belongs to
+   the emulator */
+struct sim_ctx
+{
+    struct sim_config cfg;
+    struct proto_state *proto; /* entity state, from proto_new() */
+    float time;                /* current simulated time */
+
+    struct event **evlist;      /* pending events, a heap on evtime */
+    int evcount;                /* number of pending events */
+    int evcapacity;             /* allocated slots in evlist */
+    unsigned long evserial;     /* insertion counter feeding evseq */
+    struct event *timers[2];    /* pending TIMER_INTERRUPT per entity */
+    int inflight[2];            /* FROM_LAYER3 events pending per destination */
+    float lastarrival[2];       /* arrival time of the newest of those */
+    long long lossgap;          /* CHANNEL_GEOMETRIC: packets to pass before
+                                   the next loss ... */
+    long long bitgap;           /* ... and bits before the next bit error */
+    struct pool evpool;         /* recycled events with room for a payload */
+    char *msgdata;              /* message currently given to layer 4 */
+    struct tracer *tracer;      /* binary trace, NULL when not tracing */
+    struct rng rng;             /* this run's random stream */
+    struct rto rto;             /* A's retransmission timeout */
+
+    int nsim;      /* number of messages from 5 to 4 so far */
+    int ntolayer3; /* number sent into layer 3 */
+    int nlost;     /* number lost in media */
+    int ncorrupt;  /* number corrupted by media */
+
+    /* what sim_metrics() reports */
+    int ndata;            /* packets A sent into layer 3 */
+    long long ndatabytes; /* payload bytes in those */
+    int nacks;            /* packets B sent, the ACKs */
+    int nretransmit;      /* data packets the sender says were resends */
+    int ntimeouts;        /* sender (A) timer interrupts delivered */
+    int ndelivered;       /* messages passed up to layer 5 in order */
+    int ndup;             /* repeats of the last of those */
+    int nbad;             /* anything else passed up to layer 5 */
+    int window;           /* sender's outstanding packets ... */
+    int window_max;       /* ... its peak ... */
+    float window_since;   /* ... and when it last changed */
+    double window_area;   /* integral of window over time so far */
+    double busy_area;     /* time with window > 0 so far */
+    int backlog;          /* messages the sender holds unsent */
+    int backlog_max;      /* peak of those */
+    int stalled;          /* an arrival waits for the backlog to drain */
+    int nstalls;          /* arrivals that had to */
+    struct hist *latency; /* A_output to in-order tolayer5, per message */
+    float *sendtime;      /* when message k went to layer 4, at k % SENDRING */
+    int nuntimed;         /* deliveries whose send time was overwritten */
+};
+
+/* messages that can be outstanding between layer 5 on either side and
+   still have their latency measured */
+#define SENDRING 32768
+
+/* the result of one run */
+struct sim_metrics
+{
+    float time;        /* simulated time at the end of the run */
+    int nsim;          /* messages from layer 5 */
+    int delivered;     /* messages delivered in order at layer 5 */
+    int duplicates;    /* messages delivered again */
+    int bad;           /* deliveries that were neither */
+    int packets;       /* packets sent into layer 3 */
+    int data;          /* ... by the sender */
+    int retransmits;   /* ... of which resends */
+    int acks;          /* ... by the receiver */
+    int lost;          /* packets lost in the medium */
+    int corrupt;       /* packets corrupted in the medium */
+    int timeouts;      /* sender timer interrupts */
+    double goodput;    /* delivered payload bytes per time unit */
+    double throughput; /* payload bytes sent into layer 3 per time unit */
+    double window_mean; /* time average of outstanding packets */
+    int window_max;     /* peak of outstanding packets */
+    double utilization; /* fraction of the time any were outstanding */
+    double latency_mean; /* message latency, A_output to tolayer5 ... */
+    double latency_p50;
+    double latency_p99;
+    double latency_p999;
+    double latency_max;  /* ... all 0 if nothing was delivered */
+    float srtt;          /* sender's round trip estimate at the end ... */
+    float rttvar;
+    float rto;           /* ... the timeout it would use next ... */
+    int rtt_samples;     /* ... and the samples behind it */
+    int backlog_max;     /* peak of messages queued unsent at the sender */
+    int stalls;          /* times layer 5 was held back, see --high-water */
+};
+
+#define METRICS_NONE 0
+#define METRICS_JSON 1
+#define METRICS_CSV 2
+
+/* slot i of a buffer holding payload_size-byte messages back to back */
+#define PAYLOAD_SLOT(ctx, buf, i) ((buf) + (size_t)(i) * (ctx)->cfg.payload_size)
+
+/* a full ring of cap size-byte slots moved to a new one twice the size,
+   its count slots from start on at the front; the old ring is freed */
+void *ring_grow(void *ring, size_t size, int cap, int start, int count);
+
+/* seqnums run over [0, seq_space), all of 2^32 when seq_space is 0.
+   Serial arithmetic, so no window check has to walk the window */
+uint32_t seq_next(struct sim_ctx *ctx, uint32_t seqnum, uint32_t shift);
+uint32_t seq_prev(struct sim_ctx *ctx, uint32_t seqnum);
+uint32_t seq_offset(struct sim_ctx *ctx, uint32_t seqnum, uint32_t base); /* seqnum - base */
+
+/* warns when a full window can queue on the link for longer than RTO_MAX:
+   its timers would then fire before the ACKs could come back */
+void window_check(struct sim_ctx *ctx);
+
+/* running a simulation */
+struct sim_ctx *sim_create(const struct sim_config *cfg, struct tracer *tracer);
+void sim_seed(struct sim_ctx *ctx, unsigned seed, int stream);
+void sim_run(struct sim_ctx *ctx);
+void sim_destroy(struct sim_ctx *ctx);
+void sim_metrics(const struct sim_ctx *ctx, struct sim_metrics *m);
+void latency_metrics(const struct hist *h, struct sim_metrics *m);
+void metrics_header(int format);
+void metrics_print(int format, unsigned seed, int stream, const struct sim_metrics *m);
+
+/* student-callable routines, implemented by the emulator */
+void starttimer(struct sim_ctx *ctx, int AorB, float increment);
+void stoptimer(struct sim_ctx *ctx, int AorB);
+void restarttimer(struct sim_ctx *ctx, int AorB, float increment);
+void tolayer3(struct sim_ctx *ctx, int AorB, const struct pkt *packet);
+void tolayer5(struct sim_ctx *ctx, int AorB, const char *datasent, int length);
+void sim_retransmit(struct sim_ctx *ctx);              /* count a resent data packet */
+void sim_window(struct sim_ctx *ctx, int outstanding); /* sender window occupancy */
+void sim_backlog(struct sim_ctx *ctx, int queued);     /* messages queued unsent */
+
+/* entity routines, implemented by each protocol.  proto_new() allocates
+   the protocol's state once per context; A_init() and B_init() set it
+   up for each run */
+extern const char *sim_name; /* shown in the simulator banner */
+
+struct proto_state *proto_new(struct sim_ctx *ctx);
+void proto_free(struct proto_state *ps);
+void A_output(struct sim_ctx *ctx, struct msg message);
+void A_input(struct sim_ctx *ctx, const struct pkt *packet);
+void A_timerinterrupt(struct sim_ctx *ctx);
+void A_init(struct sim_ctx *ctx);
+void B_output(struct sim_ctx *ctx, struct msg message);
+void B_input(struct sim_ctx *ctx, const struct pkt *packet);
+void B_timerinterrupt(struct sim_ctx *ctx);
+void B_init(struct sim_ctx *ctx);
+
+#endif
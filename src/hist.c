@@ -0,0 +1,102 @@
+#include <string.h>
+
+#include "hist.h"
+
+#define HIST_HALF (HIST_SUB / 2)
+#define HIST_TOP (((uint64_t)1 << HIST_MAX_BITS) - 1)
+
+/* values below HIST_SUB get a bucket each.  Above that a value whose top
+   bit is bit b lands in row b - HIST_SUB_BITS + 1, HIST_HALF buckets of
+   2^row ticks each */
+static int bucket(uint64_t v)
+{
+    int row;
+
+    if (v < HIST_SUB)
+        return (int)v;
+    row = 63 - __builtin_clzll(v) - (HIST_SUB_BITS - 1);
+    return row * HIST_HALF + (int)(v >> row);
+}
+
+/* the smallest and the largest value counted in bucket i */
+static uint64_t bucket_low(int i)
+{
+    int row;
+
+    if (i < HIST_SUB)
+        return (uint64_t)i;
+    row = i / HIST_HALF - 1;
+    return (uint64_t)(i % HIST_HALF + HIST_HALF) << row;
+}
+
+static uint64_t bucket_high(int i)
+{
+    if (i < HIST_SUB)
+        return (uint64_t)i;
+    return bucket_low(i) + ((uint64_t)1 << (i / HIST_HALF - 1)) - 1;
+}
+
+void hist_reset(struct hist *h)
+{
+    memset(h, 0, sizeof(*h));
+}
+
+void hist_record(struct hist *h, double value)
+{
+    uint64_t v;
+
+    if (value < 0.0)
+        value = 0.0;
+    v = value / HIST_UNIT >= (double)HIST_TOP ? HIST_TOP : (uint64_t)(value / HIST_UNIT + 0.5);
+    h->counts[bucket(v)]++;
+    h->total++;
+    h->sum += v;
+    if (v > h->max)
+        h->max = v;
+}
+
+void hist_merge(struct hist *into, const struct hist *from)
+{
+    int i;
+
+    for (i = 0; i < HIST_BUCKETS; i++)
+        into->counts[i] += from->counts[i];
+    into->total += from->total;
+    into->sum += from->sum;
+    if (from->max > into->max)
+        into->max = from->max;
+}
+
+/* the value at or below which pct percent of the recorded values lie,
+   reported as the top of its bucket (never above the true maximum) */
+double hist_percentile(const struct hist *h, double pct)
+{
+    uint64_t rank, seen = 0, v;
+    int i;
+
+    if (h->total == 0)
+        return 0.0;
+    rank = (uint64_t)(pct / 100.0 * h->total + 0.5);
+    if (rank < 1)
+        rank = 1;
+    if (rank > h->total)
+        rank = h->total;
+    for (i = 0; i < HIST_BUCKETS; i++)
+    {
+        seen += h->counts[i];
+        if (seen >= rank)
+            break;
+    }
+    v = bucket_high(i);
+    return (v < h->max ? v : h->max) * HIST_UNIT;
+}
+
+double hist_mean(const struct hist *h)
+{
+    return h->total ? (double)h->sum / h->total * HIST_UNIT : 0.0;
+}
+
+double hist_max(const struct hist *h)
+{
+    return h->max * HIST_UNIT;
+}
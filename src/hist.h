@@ -0,0 +1,34 @@
+#ifndef RDT_HIST_H
+#define RDT_HIST_H
+
+#include <stdint.h>
+
+/* log-linear ("HDR") histogram of non-negative values.  Values are
+   counted in ticks of HIST_UNIT; each power of two range is split into
+   HIST_SUB / 2 equal buckets, so any recorded value is known to within
+   1/128 of itself, and the histogram has the same fixed size however
+   many values it holds.  All counts are integers, so merging histograms
+   gives the same result in any order. */
+
+#define HIST_UNIT 0.001        /* one tick, in simulated time units */
+#define HIST_SUB_BITS 8
+#define HIST_SUB (1 << HIST_SUB_BITS)
+#define HIST_MAX_BITS 40       /* ticks above 2^40 count as the largest */
+#define HIST_BUCKETS ((HIST_MAX_BITS - HIST_SUB_BITS + 2) * (HIST_SUB / 2))
+
+struct hist
+{
+    uint64_t total;    /* values recorded */
+    uint64_t sum;      /* their sum, in ticks */
+    uint64_t max;      /* the largest, in ticks */
+    uint64_t counts[HIST_BUCKETS];
+};
+
+void hist_reset(struct hist *h);
+void hist_record(struct hist *h, double value);
+void hist_merge(struct hist *into, const struct hist *from);
+double hist_percentile(const struct hist *h, double pct); /* pct in [0, 100] */
+double hist_mean(const struct hist *h);
+double hist_max(const struct hist *h);
+
+#endif
@@ -0,0 +1,14 @@
+#include <stdio.h>
+#include <stdarg.h>
+
+#include "log.h"
+
+void log_inform(const char *func, const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    printf("[%s]: ", func);
+    vprintf(format, args);
+    va_end(args);
+    printf("\n");
+}
@@ -0,0 +1,39 @@
+#ifndef RDT_LOG_H
+#define RDT_LOG_H
+
+/* log levels, compared against the TRACE level given on the command line,
+   which each simulation keeps in ctx->cfg.trace */
+#define LOG_WARN 0  /* misuse of the emulator routines */
+#define LOG_INFO 1  /* protocol actions, packet losses and corruptions */
+#define LOG_EVENT 2 /* every event dispatched by the main loop */
+#define LOG_DEBUG 3 /* emulator internals */
+
+/* levels above RDT_LOG_MAX are compiled out, whatever TRACE says.  Set it
+   at configure time, e.g. cmake -DRDT_LOG_MAX=0 for benchmarking builds */
+#ifndef RDT_LOG_MAX
+#define RDT_LOG_MAX LOG_DEBUG
+#endif
+
+#define log_enabled(ctx, level) ((level) <= RDT_LOG_MAX && (level) <= (ctx)->cfg.trace)
+
+#define LOG(ctx, level, ...)             \
+    do                                   \
+    {                                    \
+        if (log_enabled(ctx, level))     \
+            printf(__VA_ARGS__);         \
+    } while (0)
+
+/* "[func]: message" line from a protocol entity, at LOG_INFO */
+#define inform(ctx, func, ...)                 \
+    do                                         \
+    {                                          \
+        if (log_enabled(ctx, LOG_INFO))        \
+            log_inform(func, __VA_ARGS__);     \
+    } while (0)
+
+/* payload bytes shown when a message appears in a log line */
+#define PREVIEW(len) ((len) < 20 ? (len) : 20)
+
+void log_inform(const char *func, const char *format, ...);
+
+#endif
@@ -0,0 +1,88 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "pool.h"
+
+#define POOL_ALIGN 16
+
+struct pool_slab
+{
+    struct pool_slab *next;
+};
+
+/* slab header padded so the first object stays aligned */
+#define SLAB_HDR ((sizeof(struct pool_slab) + POOL_ALIGN - 1) & ~(size_t)(POOL_ALIGN - 1))
+
+void pool_init(struct pool *p, size_t objsize, int perslab)
+{
+    if (objsize < sizeof(void *))
+        objsize = sizeof(void *);
+    p->objsize = (objsize + POOL_ALIGN - 1) & ~(size_t)(POOL_ALIGN - 1);
+    p->perslab = perslab > 0 ? perslab : 1;
+    p->freelist = NULL;
+    p->slabs = NULL;
+    p->inuse = 0;
+    p->highwater = 0;
+    p->nalloc = 0;
+    p->nslabs = 0;
+}
+
+/* carve a new slab and thread all of its objects onto the free list */
+static void pool_grow(struct pool *p)
+{
+    struct pool_slab *slab;
+    char *obj;
+    int i;
+
+    slab = (struct pool_slab *)malloc(SLAB_HDR + p->objsize * p->perslab);
+    if (slab == NULL)
+    {
+        printf("INTERNAL PANIC: out of memory growing object pool\n");
+        exit(1);
+    }
+    slab->next = p->slabs;
+    p->slabs = slab;
+    p->nslabs++;
+
+    obj = (char *)slab + SLAB_HDR + p->objsize * (p->perslab - 1);
+    for (i = 0; i < p->perslab; i++, obj -= p->objsize)
+    {
+        *(void **)obj = p->freelist;
+        p->freelist = obj;
+    }
+}
+
+void *pool_get(struct pool *p)
+{
+    void *obj;
+
+    if (p->freelist == NULL)
+        pool_grow(p);
+    obj = p->freelist;
+    p->freelist = *(void **)obj;
+    p->nalloc++;
+    if (++p->inuse > p->highwater)
+        p->highwater = p->inuse;
+    return obj;
+}
+
+void pool_put(struct pool *p, void *obj)
+{
+    *(void **)obj = p->freelist;
+    p->freelist = obj;
+    p->inuse--;
+}
+
+void pool_destroy(struct pool *p)
+{
+    struct pool_slab *slab, *next;
+
+    for (slab = p->slabs; slab != NULL; slab = next)
+    {
+        next = slab->next;
+        free(slab);
+    }
+    p->slabs = NULL;
+    p->freelist = NULL;
+    p->inuse = 0;
+}
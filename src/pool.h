@@ -0,0 +1,29 @@
+#ifndef RDT_POOL_H
+#define RDT_POOL_H
+
+#include <stddef.h>
+
+/* fixed-size object pool: objects are carved out of slabs obtained from
+   malloc and recycled through a free list, so once the pool has grown
+   to the peak number of live objects it never calls the system
+   allocator again.  Slabs are only returned by pool_destroy(). */
+struct pool_slab;
+
+struct pool
+{
+    size_t objsize;          /* bytes per object (rounded for alignment) */
+    int perslab;             /* objects carved from each slab */
+    void *freelist;          /* recycled objects, linked through their first word */
+    struct pool_slab *slabs; /* every slab allocated so far */
+    long inuse;              /* objects currently handed out */
+    long highwater;          /* peak of inuse */
+    long nalloc;             /* total pool_get() calls */
+    long nslabs;             /* slabs obtained from malloc */
+};
+
+void pool_init(struct pool *p, size_t objsize, int perslab);
+void *pool_get(struct pool *p);
+void pool_put(struct pool *p, void *obj);
+void pool_destroy(struct pool *p);
+
+#endif
@@ -0,0 +1,151 @@
+#include <string.h>
+
+#include "rng.h"
+
+static const char *kind_names[RNG_NKINDS] = {"xoshiro", "rand"};
+
+/************************ xoshiro256** ******************************/
+/* Blackman and Vigna, https://prng.di.unimi.it/xoshiro256starstar.c */
+
+static inline uint64_t rotl(uint64_t x, int k)
+{
+    return (x << k) | (x >> (64 - k));
+}
+
+static uint64_t xoshiro_next(uint64_t *s)
+{
+    uint64_t result = rotl(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl(s[3], 45);
+    return result;
+}
+
+/* the state is filled from splitmix64, as the authors recommend */
+static void xoshiro_seed(uint64_t *s, uint64_t seed)
+{
+    uint64_t z;
+    int i;
+
+    for (i = 0; i < 4; i++)
+    {
+        z = (seed += 0x9e3779b97f4a7c15ULL);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        s[i] = z ^ (z >> 31);
+    }
+}
+
+void rng_jump(struct rng *g)
+{
+    static const uint64_t jump[] = {0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL,
+                                    0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL};
+    uint64_t t[4] = {0, 0, 0, 0};
+    int i, b;
+
+    if (g->kind != RNG_XOSHIRO)
+        return;
+    for (i = 0; i < 4; i++)
+        for (b = 0; b < 64; b++)
+        {
+            if (jump[i] & (1ULL << b))
+            {
+                t[0] ^= g->u.s[0];
+                t[1] ^= g->u.s[1];
+                t[2] ^= g->u.s[2];
+                t[3] ^= g->u.s[3];
+            }
+            xoshiro_next(g->u.s);
+        }
+    memcpy(g->u.s, t, sizeof(t));
+}
+
+/*********************** glibc rand() *******************************/
+/* the TYPE_3 additive feedback generator behind glibc's srand() and
+   rand(): x[i] = x[i-3] + x[i-31], seeded by a Park-Miller LCG and run
+   310 steps before the first result */
+
+#define LFG_DEG 31
+#define LFG_SEP 3
+
+static int32_t lfg_next(struct rng *g)
+{
+    uint32_t v;
+
+    v = (uint32_t)g->u.lfg.tbl[g->u.lfg.f] + (uint32_t)g->u.lfg.tbl[g->u.lfg.r];
+    g->u.lfg.tbl[g->u.lfg.f] = (int32_t)v;
+    if (++g->u.lfg.f == LFG_DEG)
+        g->u.lfg.f = 0;
+    if (++g->u.lfg.r == LFG_DEG)
+        g->u.lfg.r = 0;
+    return (int32_t)(v >> 1);
+}
+
+static void lfg_seed(struct rng *g, unsigned seed)
+{
+    int32_t word, hi, lo;
+    int i;
+
+    if (seed == 0)
+        seed = 1;
+    word = (int32_t)seed;
+    g->u.lfg.tbl[0] = word;
+    for (i = 1; i < LFG_DEG; i++)
+    {
+        hi = word / 127773;
+        lo = word % 127773;
+        word = 16807 * lo - 2836 * hi;
+        if (word < 0)
+            word += 2147483647;
+        g->u.lfg.tbl[i] = word;
+    }
+    g->u.lfg.f = LFG_SEP;
+    g->u.lfg.r = 0;
+    for (i = 0; i < 10 * LFG_DEG; i++)
+        lfg_next(g);
+}
+
+/*********************************************************************/
+
+void rng_seed(struct rng *g, int kind, unsigned seed)
+{
+    g->kind = kind;
+    if (kind == RNG_RAND)
+        lfg_seed(g, seed);
+    else
+        xoshiro_seed(g->u.s, seed);
+}
+
+int32_t rng_next31(struct rng *g)
+{
+    if (g->kind == RNG_RAND)
+        return lfg_next(g);
+    return (int32_t)(xoshiro_next(g->u.s) >> 33);
+}
+
+double rng_uniform(struct rng *g)
+{
+    if (g->kind == RNG_RAND)
+        return lfg_next(g) / 2147483647.0; /* RAND_MAX, as jimsrand() had it */
+    return (xoshiro_next(g->u.s) >> 11) * (1.0 / 9007199254740991.0);
+}
+
+int rng_parse(const char *name)
+{
+    int kind;
+
+    for (kind = 0; kind < RNG_NKINDS; kind++)
+        if (strcmp(name, kind_names[kind]) == 0)
+            return kind;
+    return -1;
+}
+
+const char *rng_name(int kind)
+{
+    return kind >= 0 && kind < RNG_NKINDS ? kind_names[kind] : "unknown";
+}
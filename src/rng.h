@@ -0,0 +1,41 @@
+#ifndef RDT_RNG_H
+#define RDT_RNG_H
+
+#include <stdint.h>
+
+/* per-simulation random number generators.  Each one is a plain value,
+   so simulations running side by side draw from their own streams */
+
+#define RNG_XOSHIRO 0 /* xoshiro256**, the default */
+#define RNG_RAND 1    /* glibc's rand(), to reproduce runs made with it */
+#define RNG_NKINDS 2
+
+struct rng
+{
+    int kind; /* RNG_* */
+    union
+    {
+        uint64_t s[4]; /* xoshiro256** state */
+        struct
+        {
+            int32_t tbl[31]; /* additive feedback table */
+            int f, r;        /* front and rear taps into tbl */
+        } lfg;
+    } u;
+};
+
+/* rng_seed(g, RNG_RAND, s) then rng_next31() draws what srand(s) then
+   rand() does with glibc, on any platform */
+void rng_seed(struct rng *g, int kind, unsigned seed);
+
+/* xoshiro only: advance by 2^128 draws.  Seed once and jump k times to
+   get substream k; substreams never overlap in practice */
+void rng_jump(struct rng *g);
+
+int32_t rng_next31(struct rng *g); /* uniform on [0, 2^31 - 1] */
+double rng_uniform(struct rng *g); /* uniform on [0, 1] */
+
+int rng_parse(const char *name); /* -1 if name is unknown */
+const char *rng_name(int kind);
+
+#endif
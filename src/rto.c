@@ -0,0 +1,76 @@
+#include <string.h>
+
+#include "rto.h"
+
+static const char *rto_names[RTO_NKINDS] = {"adaptive", "fixed"};
+
+static float clamp(const struct rto *r, float t)
+{
+    return t < RTO_MIN ? RTO_MIN : t > r->max ? r->max : t;
+}
+
+void rto_init(struct rto *r, int kind, float max)
+{
+    r->kind = kind;
+    r->max = max < RTO_MAX_LOW ? RTO_MAX_LOW : max > RTO_MAX ? RTO_MAX : max;
+    r->srtt = 0.0f;
+    r->rttvar = 0.0f;
+    r->timeout = RTO_INITIAL;
+    r->nsamples = 0;
+    r->nbackoff = 0;
+}
+
+void rto_sample(struct rto *r, float rtt)
+{
+    float err;
+
+    if (r->nsamples++ == 0)
+    {
+        r->srtt = rtt;
+        r->rttvar = rtt / 2;
+    }
+    else
+    {
+        /* gains of 1/4 and 1/8; rttvar uses the old srtt */
+        err = rtt - r->srtt;
+        r->rttvar += ((err < 0 ? -err : err) - r->rttvar) / 4;
+        r->srtt += err / 8;
+    }
+    r->nbackoff = 0;
+    r->timeout = clamp(r, r->srtt + 4 * r->rttvar);
+}
+
+void rto_backoff(struct rto *r)
+{
+    r->nbackoff++;
+    r->timeout = clamp(r, r->timeout * 2);
+}
+
+float rto_timeout(const struct rto *r)
+{
+    float t = RTO_INITIAL;
+    int n;
+
+    if (r->kind != RTO_FIXED)
+        return r->timeout;
+    /* the fixed timeout backs off too: once queueing pushes the RTT
+       past it, every expiry would resend the window into the queue */
+    for (n = 0; n < r->nbackoff && t < r->max; n++)
+        t *= 2;
+    return clamp(r, t);
+}
+
+int rto_parse(const char *name)
+{
+    int kind;
+
+    for (kind = 0; kind < RTO_NKINDS; kind++)
+        if (strcmp(name, rto_names[kind]) == 0)
+            return kind;
+    return -1;
+}
+
+const char *rto_name(int kind)
+{
+    return kind >= 0 && kind < RTO_NKINDS ? rto_names[kind] : "unknown";
+}
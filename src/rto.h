@@ -0,0 +1,47 @@
+#ifndef RDT_RTO_H
+#define RDT_RTO_H
+
+/* retransmission timeout of a sender, from the round trip times of its
+   acknowledged packets (Jacobson/Karels, as in RFC 6298).  The
+   protocols feed it samples and ask it for the value to give
+   starttimer(); the estimate is kept with either kind, so the metrics
+   show it even when the timeout stays fixed */
+
+#define RTO_ADAPTIVE 0 /* SRTT + 4 RTTVAR, doubled on every timeout */
+#define RTO_FIXED 1    /* RTO_INITIAL, doubled on every timeout */
+#define RTO_NKINDS 2
+
+#define RTO_INITIAL 20.0f /* before the first sample */
+#define RTO_MIN 2.0f      /* one hop takes at least 1 time unit */
+#define RTO_MAX 60000.0f  /* the most any cap can be, RFC 6298's 60 s */
+#define RTO_MAX_LOW 1000.0f /* the least */
+
+struct rto
+{
+    int kind;      /* RTO_* */
+    float srtt;    /* smoothed round trip time ... */
+    float rttvar;  /* ... and its mean deviation */
+    float timeout; /* what rto_timeout() returns */
+    float max;     /* cap of the timeout, backoff included */
+    int nsamples;  /* samples taken */
+    int nbackoff;  /* timeouts since the last sample */
+};
+
+/* max: the longest round trip the sender can see, queueing included.
+   The cap is kept within [RTO_MAX_LOW, RTO_MAX]; below the round trip,
+   every packet would time out and Karn's rule reject every sample */
+void rto_init(struct rto *r, int kind, float max);
+
+/* a round trip measured on a packet sent only once.  By Karn's rule a
+   resent packet gives no sample: its ACK may be for either copy */
+void rto_sample(struct rto *r, float rtt);
+
+/* the timer expired: double the timeout until the next sample */
+void rto_backoff(struct rto *r);
+
+float rto_timeout(const struct rto *r);
+
+int rto_parse(const char *name); /* -1 if name is unknown */
+const char *rto_name(int kind);
+
+#endif
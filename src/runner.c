@@ -0,0 +1,216 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "runner.h"
+
+/* Each worker owns a contiguous range of replication indices and runs
+   them from the front.  A worker whose range is empty steals the back
+   half of another worker's range.  Replications never create new work,
+   so a worker that finds every range empty is done.  Ranges are
+   guarded by a mutex each; a replication takes far longer than the lock,
+   so there is no point in a lock-free deque here */
+
+struct worker
+{
+    pthread_t tid;
+    pthread_mutex_t lock;
+    int next; /* replications [next, end) are queued here */
+    int end;
+    long nstolen; /* replications taken from other workers */
+    struct hist *latency; /* latencies of the replications run here */
+    struct runner *run;
+    int self;
+};
+
+struct runner
+{
+    const struct sim_config *cfg;
+    unsigned seedbase;
+    struct rng *streams; /* starting state of each replication, or NULL */
+    struct rep_result *results;
+    struct tracer *tracer; /* only with a single worker */
+    struct worker *workers;
+    int nworkers;
+};
+
+int runner_cpus(void)
+{
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+}
+
+/* next replication from w's own range, -1 if it is empty */
+static int take(struct worker *w)
+{
+    int r = -1;
+
+    pthread_mutex_lock(&w->lock);
+    if (w->next < w->end)
+        r = w->next++;
+    pthread_mutex_unlock(&w->lock);
+    return r;
+}
+
+/* move the back half of some other worker's range to w.  Returns 0 if
+   there was nothing left anywhere */
+static int steal(struct worker *w)
+{
+    struct runner *run = w->run;
+    struct worker *v;
+    int i, left, mid, end;
+
+    for (i = 1; i < run->nworkers; i++)
+    {
+        v = &run->workers[(w->self + i) % run->nworkers];
+        pthread_mutex_lock(&v->lock);
+        left = v->end - v->next;
+        if (left > 0)
+        {
+            end = v->end;
+            mid = end - (left + 1) / 2;
+            v->end = mid;
+            pthread_mutex_unlock(&v->lock);
+            /* [mid, end) is in nobody's range until w takes it, so the
+               two locks never need to be held together */
+            pthread_mutex_lock(&w->lock);
+            w->next = mid;
+            w->end = end;
+            w->nstolen += end - mid;
+            pthread_mutex_unlock(&w->lock);
+            return 1;
+        }
+        pthread_mutex_unlock(&v->lock);
+    }
+    return 0;
+}
+
+static void *work(void *arg)
+{
+    struct worker *w = (struct worker *)arg;
+    struct runner *run = w->run;
+    struct rep_result *res;
+    struct sim_ctx *ctx;
+    int r;
+
+    ctx = sim_create(run->cfg, run->tracer);
+    for (;;)
+    {
+        r = take(w);
+        if (r < 0)
+        {
+            if (!steal(w))
+                break;
+            continue;
+        }
+        res = &run->results[r];
+        if (run->streams != NULL)
+        {
+            res->seed = run->seedbase;
+            res->stream = r;
+            ctx->rng = run->streams[r];
+        }
+        else
+        {
+            res->seed = run->seedbase + r;
+            res->stream = 0;
+            sim_seed(ctx, res->seed, 0);
+        }
+        sim_run(ctx);
+        sim_metrics(ctx, &res->m);
+        if (w->latency != NULL)
+            hist_merge(w->latency, ctx->latency);
+    }
+    sim_destroy(ctx);
+    return NULL;
+}
+
+long run_replications(const struct sim_config *cfg, int n, unsigned seedbase,
+                      int nthreads, struct tracer *tracer, struct rep_result *results,
+                      struct hist *latency)
+{
+    struct runner run;
+    struct worker *w;
+    long nstolen = 0;
+    int i;
+
+    if (nthreads < 1)
+        nthreads = runner_cpus();
+    if (nthreads > n)
+        nthreads = n;
+    run.cfg = cfg;
+    run.seedbase = seedbase;
+    run.results = results;
+    run.tracer = nthreads == 1 ? tracer : NULL;
+
+    /* substream r is r jumps past the seed: lay them all out here, one
+       jump apart, rather than have each worker jump from the start */
+    run.streams = NULL;
+    if (cfg->rng_kind == RNG_XOSHIRO)
+    {
+        run.streams = (struct rng *)malloc(sizeof(struct rng) * n);
+        if (run.streams == NULL)
+        {
+            printf("INTERNAL PANIC: out of memory for replication streams\n");
+            exit(1);
+        }
+        rng_seed(&run.streams[0], cfg->rng_kind, seedbase);
+        for (i = 1; i < n; i++)
+        {
+            run.streams[i] = run.streams[i - 1];
+            rng_jump(&run.streams[i]);
+        }
+    }
+    run.nworkers = nthreads;
+    run.workers = (struct worker *)calloc(nthreads, sizeof(struct worker));
+    if (run.workers == NULL)
+    {
+        printf("INTERNAL PANIC: out of memory for replication workers\n");
+        exit(1);
+    }
+    for (i = 0; i < nthreads; i++)
+    {
+        w = &run.workers[i];
+        pthread_mutex_init(&w->lock, NULL);
+        w->next = (int)((long)n * i / nthreads);
+        w->end = (int)((long)n * (i + 1) / nthreads);
+        w->run = &run;
+        w->self = i;
+        if (latency != NULL)
+        {
+            w->latency = (struct hist *)malloc(sizeof(struct hist));
+            if (w->latency == NULL)
+            {
+                printf("INTERNAL PANIC: out of memory for replication workers\n");
+                exit(1);
+            }
+            hist_reset(w->latency);
+        }
+    }
+
+    /* the calling thread is worker 0 */
+    for (i = 1; i < nthreads; i++)
+        if (pthread_create(&run.workers[i].tid, NULL, work, &run.workers[i]) != 0)
+        {
+            printf("INTERNAL PANIC: cannot start replication worker %d\n", i);
+            exit(1);
+        }
+    work(&run.workers[0]);
+    for (i = 1; i < nthreads; i++)
+        pthread_join(run.workers[i].tid, NULL);
+
+    for (i = 0; i < nthreads; i++)
+    {
+        nstolen += run.workers[i].nstolen;
+        if (latency != NULL)
+        {
+            hist_merge(latency, run.workers[i].latency);
+            free(run.workers[i].latency);
+        }
+        pthread_mutex_destroy(&run.workers[i].lock);
+    }
+    free(run.workers);
+    free(run.streams);
+    return nstolen;
+}
@@ -0,0 +1,28 @@
+#ifndef RDT_RUNNER_H
+#define RDT_RUNNER_H
+
+#include "emulator.h"
+
+/* batch replications spread over worker threads.  Replication r always
+   draws from substream r of seedbase (with RNG_RAND, from srand(seedbase
+   + r)) and its result always lands in results[r], so the output does
+   not depend on how many threads ran it or which thread picked it up. */
+
+struct rep_result
+{
+    unsigned seed; /* seed of the replication's stream ... */
+    int stream;    /* ... and which substream of it */
+    struct sim_metrics m;
+};
+
+/* nthreads < 1 means one per online CPU.  tracer (may be NULL) records
+   every replication and so needs nthreads == 1.  Returns the number of
+   replications that had to be stolen from another worker.  latency, if
+   not NULL, gets the message latencies of every replication merged */
+long run_replications(const struct sim_config *cfg, int n, unsigned seedbase,
+                      int nthreads, struct tracer *tracer, struct rep_result *results,
+                      struct hist *latency);
+
+int runner_cpus(void);
+
+#endif
@@ -4,47 +4,11 @@
 #include <assert.h>
 #include <time.h>
 #include <stdarg.h>
+#include <stdint.h>
 
-/* ******************************************************************
- ALTERNATING BIT AND GO-BACK-N NETWORK EMULATOR: VERSION 1.1  J.F.Kurose
-
-   This code should be used for PA2, unidirectional or bidirectional
-   data transfer protocols (from A to B. Bidirectional transfer of data
-   is for extra credit and is not required).  Network properties:
-   - one way network delay averages five time units (longer if there
-       are other messages in the channel for GBN), but can be larger
-   - packets can be corrupted (either the header or the data portion)
-       or lost, according to user-defined probabilities
-   - packets will be delivered in the order in which they were sent
-       (although some can be lost).
-**********************************************************************/
-
-#define BIDIRECTIONAL 0 /* change to 1 if you're doing extra credit */
-/* and write a routine called B_output */
-
-/* a "msg" is the data unit passed from layer 5 (teachers code) to layer  */
-/* 4 (students' code).  It contains the data (characters) to be delivered */
-/* to layer 5 via the students transport level protocol entities.         */
-struct msg
-{
-    char data[20];
-};
-
-/* a packet is the data unit passed from layer 4 (students code) to layer */
-/* 3 (teachers code).  Note the pre-defined packet structure, which all   */
-/* students must follow. */
-struct pkt
-{
-    int seqnum;
-    int acknum;
-    int checksum;
-    char payload[20];
-};
-
-void starttimer(int AorB, float increment);
-void stoptimer(int AorB);
-void tolayer3(int AorB, struct pkt packet);
-void tolayer5(int AorB, char datasent[20]);
+#include "emulator.h"
+#include "checksum.h"
+#include "log.h"
 
 /********* STUDENTS WRITE THE NEXT SEVEN ROUTINES *********/
 /************ STUDENTS NEED TO MODIFY BELOW CODE************/
@@ -52,736 +16,599 @@ void tolayer5(int AorB, char datasent[20]);
 // Pre Define
 #define A 0
 #define B 1
-#define TIMEOUT 20
-#define BUF_SZ 10000
-#define WINDOW_SZ 10
-
-int sender_buf_upper;
-int receiver_buf_upper;
-int window_left; // Window Left
-int window_right; // Window Right
-
-char sender_buffer[BUF_SZ][20];
-char receiver_buffer[WINDOW_SZ][20];
-
-int A_seqnum;
-int B_acknum;
-int left_seqnum;
-
-void inform(const char* __func, const char* format, ...);
+#define MAP_WORDS(n) (((n) + 63) / 64) // uint64_t words in a bitmap of n slots
+#define SACK_BYTES(ctx) (((ctx)->cfg.window + 7) / 8) // ACK payload, a bit per receiver slot
+
+const char *sim_name = "Selective Repeat";
+
+struct proto_state
+{
+    int sender_buf_upper;
+    int buf_size; // sender slots allocated, doubles when the queue fills up
+    int receiver_left; // receiver slot of B_acknum
+    int receiver_held; // receiver slots in use
+    int window_left; // Window Left
+    int window_right; // Window Right
+
+    // buf_size slots each
+    char *sender_buffer; // payload_size bytes a slot
+    uint32_t *sender_cksum; // payload partial checksum of each slot
+    float *sent_at; // when each slot was sent, -1 once resent or acked
+    uint64_t *acked; // bitmap, slots B has confirmed
+    // a timer per outstanding slot: a min-heap of slots on deadline,
+    // with the one emulator timer armed for the earliest of them
+    float *deadline;
+    int *timer_heap;
+    int *timer_pos; // slot's index in timer_heap, -1 if not running
+    int timer_count;
+    float armed; // deadline the emulator timer is set for, -1 if none
+    uint8_t *sack; // payload of the ACK being sent, SACK_BYTES
+    char *receiver_buffer; // window slots of payload_size bytes, a ring from receiver_left
+    uint64_t *received; // bitmap, receiver slots holding a packet
+
+    uint32_t A_seqnum;
+    uint32_t B_acknum;
+    uint32_t left_seqnum;
+    int ack_pending; // in-order packets B has not ACKed yet, see --ack-every
+};
 
-int calc_cSum(struct pkt packet)
+int calc_cSum(struct sim_ctx *ctx, const struct pkt *packet)
 {
-    int c_sum = 0;
-    int len = sizeof(packet.payload) / sizeof(char);
-    c_sum += packet.seqnum;
-    c_sum += packet.acknum;
-
-    for(int i = 0; i < len; ++i)
-        c_sum += packet.payload[i];
-
-    return c_sum;
+    uint32_t partial = cksum_payload(ctx->cfg.cksum_kind, packet->payload, packet->length);
+    return cksum_finish(ctx->cfg.cksum_kind, partial, packet->seqnum, packet->acknum);
 }
 
-int checksum(struct pkt packet)
+int checksum(struct sim_ctx *ctx, const struct pkt *packet)
 {
-    return calc_cSum(packet) == packet.checksum ? 1 : 0;
+    return calc_cSum(ctx, packet) == packet->checksum ? 1 : 0;
 }
 
-struct pkt make_packet(int seqnum, char payload[20])
+// partial: cksum_payload() of payload, kept by the caller for resends
+struct pkt make_packet(struct sim_ctx *ctx, uint32_t seqnum, char *payload, uint32_t partial)
 {
     struct pkt packet;
     packet.seqnum = seqnum;
     packet.acknum = 0;
-    for(int i = 0; i < 20; i++)
-        packet.payload[i] = payload[i];
-    packet.checksum = calc_cSum(packet);          
+    packet.length = ctx->cfg.payload_size;
+    packet.payload = payload; // tolayer3 takes its own copy
+    packet.checksum = cksum_finish(ctx->cfg.cksum_kind, partial, seqnum, 0);
     return packet;
 }
 
-void send_packet(int AorB, int seqnum, char payload[20])
+void send_packet(struct sim_ctx *ctx, int AorB, uint32_t seqnum, char *payload, uint32_t partial)
 {
     const char* sender = A == AorB ? "A_output" : "B_output";
-    inform(sender, "Send Pkt | Seq: %d | Msg: %.20s", seqnum, payload);
-    struct pkt packet = make_packet(seqnum, payload);
-    tolayer3(AorB, packet);
-}
-
-void send_range(int AorB, int seq_start, int shift){
-    int ptr = window_right;
-    int last = (ptr + shift + BUF_SZ) % BUF_SZ;
-    int seqnum = seq_start;
-    while(ptr != last){
-        send_packet(AorB, seqnum, sender_buffer[ptr]);
-        ptr = (ptr + 1) % BUF_SZ;
-        seqnum = (seqnum + 1) % (WINDOW_SZ + 1); 
-    }
+    inform(ctx, sender, "Send Pkt | Seq: %u | Msg: %.*s", seqnum, PREVIEW(ctx->cfg.payload_size), payload);
+    struct pkt packet = make_packet(ctx, seqnum, payload, partial);
+    tolayer3(ctx, AorB, &packet);
 }
 
-struct pkt make_ack(int acknum)
+void timer_swap(struct proto_state *s, int i, int j)
 {
-    struct pkt packet;
-    packet.seqnum = acknum;
-    packet.acknum = acknum;
-    for(int i = 0; i < 20; i++)
-        packet.payload[i] = 0;
-    packet.checksum = calc_cSum(packet);
-    return packet;
+    int t = s->timer_heap[i];
+    s->timer_heap[i] = s->timer_heap[j];
+    s->timer_heap[j] = t;
+    s->timer_pos[s->timer_heap[i]] = i;
+    s->timer_pos[s->timer_heap[j]] = j;
 }
 
-void send_ack(int AorB, int acknum)
+void timer_up(struct proto_state *s, int i)
 {
-    const char* sender = A == AorB ? "A_input" : "B_input";
-    inform(sender, "Send ACK[%d]", acknum);
-    struct pkt packet = make_ack(acknum);
-    tolayer3(AorB, packet);
+    while(i > 0 && s->deadline[s->timer_heap[(i - 1) / 2]] > s->deadline[s->timer_heap[i]]){
+        timer_swap(s, i, (i - 1) / 2);
+        i = (i - 1) / 2;
+    }
 }
 
-int is_ACK_valid(struct pkt *packet, int base, int right)
+void timer_down(struct proto_state *s, int i)
 {
-    int shift = 0;
-    for(int i = base; i != right; i = (i + 1) % (WINDOW_SZ + 1)){
-        shift++;
-        if(packet->acknum == i)
-            return shift;
+    for(;;){
+        int min = i, l = 2 * i + 1, r = 2 * i + 2;
+        if(l < s->timer_count && s->deadline[s->timer_heap[l]] < s->deadline[s->timer_heap[min]])
+            min = l;
+        if(r < s->timer_count && s->deadline[s->timer_heap[r]] < s->deadline[s->timer_heap[min]])
+            min = r;
+        if(min == i)
+            return;
+        timer_swap(s, i, min);
+        i = min;
     }
-    return 0;
 }
 
-int is_Seq_valid(struct pkt *packet, int base, int right)
+// (re)start slot's timer to go off one RTO from now
+void timer_set(struct sim_ctx *ctx, int slot)
 {
-    int shift = 0;
-    for(int i = base; i != right; i = (i + 1) % (WINDOW_SZ + 1)){
-        shift++;
-        if(packet->seqnum == i)
-            return shift;
+    struct proto_state *s = ctx->proto;
+    s->deadline[slot] = ctx->time + rto_timeout(&ctx->rto);
+    if(s->timer_pos[slot] < 0){
+        s->timer_pos[slot] = s->timer_count;
+        s->timer_heap[s->timer_count++] = slot;
+        timer_up(s, s->timer_pos[slot]);
+    } else {
+        // deadlines only move later
+        timer_down(s, s->timer_pos[slot]);
     }
-    return 0;
 }
 
-int get_sender_window_shift(uint32_t start, uint32_t end)
+void timer_clear(struct sim_ctx *ctx, int slot)
 {
-    assert(start <= end);
-    int shift = 0;
-    for(int i = start; i < end; i++){
-        if(sender_buffer[i][0] == '\0')
-            shift++;
-        else
-            return shift;
+    struct proto_state *s = ctx->proto;
+    int i = s->timer_pos[slot];
+    if(i < 0)
+        return;
+    s->timer_count--;
+    if(i != s->timer_count){
+        timer_swap(s, i, s->timer_count);
+        timer_up(s, i);
+        timer_down(s, s->timer_pos[s->timer_heap[i]]);
     }
-    return shift;
+    s->timer_pos[slot] = -1;
 }
 
-int get_receiver_window_shift(uint32_t start, uint32_t end)
+// arm the emulator timer for the earliest deadline, if it isn't already
+void timer_sync(struct sim_ctx *ctx)
 {
-    int shift = 0;
-    for(int i = start; i < end; i++){
-        if(receiver_buffer[i][0] != '\0')
-            shift++;
-        else
-            return shift;
+    struct proto_state *s = ctx->proto;
+    if(s->timer_count == 0){
+        if(s->armed >= 0)
+            stoptimer(ctx, A);
+        s->armed = -1;
+        return;
+    }
+    float first = s->deadline[s->timer_heap[0]];
+    if(first != s->armed){
+        restarttimer(ctx, A, first - ctx->time);
+        s->armed = first;
     }
-    return shift;
 }
 
-void clean_pkt(char (*buffer)[20], uint32_t loc)
+// receiver slot of seqnum B_acknum + offset
+int receiver_slot(struct sim_ctx *ctx, int offset)
 {
-    buffer[loc][0] = '\0';
+    return (ctx->proto->receiver_left + offset) % ctx->cfg.window;
 }
 
-int get_next_Seqnum(const int seqnum, const int shift)
+int bit_test(const uint64_t *map, int i)
 {
-    return (seqnum + shift) % (WINDOW_SZ + 1);
+    return map[i / 64] >> (i % 64) & 1;
 }
 
-int get_last_Seqnum(const int seqnum)
+void bit_set(uint64_t *map, int i)
 {
-    return (seqnum + WINDOW_SZ) % (WINDOW_SZ + 1);
+    map[i / 64] |= (uint64_t)1 << (i % 64);
 }
 
-void inform(const char* __func, const char* format, ...)
+void bit_clear(uint64_t *map, int i)
 {
-    va_list args;
-    va_start(args, format);
-    printf("[%s]: ", __func);
-    vprintf(format, args);
-    va_end(args);
-    printf("\n");
+    map[i / 64] &= ~((uint64_t)1 << (i % 64));
 }
 
-void cache_sender_msg(struct msg* msg)
+// how many bits from i on are set, wrapping at n, at most max.
+// A word at a time: bits past n are never set, so a run stops there
+// and carries on from 0
+int bit_run(const uint64_t *map, int n, int i, int max)
 {
-    memcpy(sender_buffer[sender_buf_upper], msg->data, sizeof(msg->data));
-    sender_buf_upper = (sender_buf_upper + 1) % BUF_SZ;
+    int run = 0;
+    while(run < max){
+        int bit = i % 64;
+        uint64_t clear = ~map[i / 64] >> bit;
+        int len = clear ? __builtin_ctzll(clear) : 64 - bit;
+        run += len;
+        if(i + len == n)
+            i = 0;
+        else if(clear)
+            break;
+        else
+            i += len;
+    }
+    return run < max ? run : max;
 }
 
-void cache_receiver_msg(char payload[20], int seq_shift)
-{
-    memcpy(receiver_buffer[seq_shift], payload, sizeof(char) * 20);
-    receiver_buf_upper = (receiver_buf_upper + 1) % WINDOW_SZ;
+void send_range(struct sim_ctx *ctx, int AorB, uint32_t seq_start, int shift){
+    struct proto_state *s = ctx->proto;
+    int bufsz = s->buf_size;
+    int ptr = s->window_right;
+    int last = (ptr + shift + bufsz) % bufsz;
+    uint32_t seqnum = seq_start;
+    while(ptr != last){
+        send_packet(ctx, AorB, seqnum, PAYLOAD_SLOT(ctx, s->sender_buffer, ptr), s->sender_cksum[ptr]);
+        s->sent_at[ptr] = ctx->time;
+        timer_set(ctx, ptr);
+        ptr = (ptr + 1) % bufsz;
+        seqnum = seq_next(ctx, seqnum, 1);
+    }
 }
 
-/* called from layer 5, passed the data to be sent to other side */
-void A_output(struct msg message)
+// bitmap bytes in an ACK: no packet may carry more than payload_size,
+// so with tiny payloads the far end of the window goes unreported
+int sack_len(struct sim_ctx *ctx)
 {
-    printf("------------------------------\n");
-    if(sender_buf_upper == window_left){
-        inform(__FUNCTION__, "Start Timer");
-        starttimer(A, TIMEOUT);
-    }
-    cache_sender_msg(&message);
-    if((sender_buf_upper - window_left + WINDOW_SZ) % WINDOW_SZ <= WINDOW_SZ){
-        send_packet(A, A_seqnum, message.data);    
-        A_seqnum = get_next_Seqnum(A_seqnum, 1);
-        window_right = (window_right + 1) % BUF_SZ;
-    } else {
-        inform(__FUNCTION__, "Window is full, BUF the msg: %.20s", message.data);
-    }
+    return SACK_BYTES(ctx) < ctx->cfg.payload_size ? SACK_BYTES(ctx) : ctx->cfg.payload_size;
 }
 
-/* need be completed only for extra credit */
-void B_output(struct msg message)
+// acknum: the seqnum B expects next, everything before it has arrived.
+// Bit i of the payload: seqnum acknum + i is buffered out of order
+struct pkt make_ack(struct sim_ctx *ctx, uint32_t acknum)
 {
-    inform(__FUNCTION__, "Got Msg");
+    struct proto_state *s = ctx->proto;
+    struct pkt packet;
+    int len = sack_len(ctx);
+    memset(s->sack, 0, len);
+    for(int i = 1; i < ctx->cfg.window && i < len * 8; i++)
+        if(bit_test(s->received, receiver_slot(ctx, i)))
+            s->sack[i / 8] |= 1 << (i % 8);
+    packet.seqnum = acknum;
+    packet.acknum = acknum;
+    packet.length = len;
+    packet.payload = (char *)s->sack;
+    uint32_t partial = cksum_payload(ctx->cfg.cksum_kind, packet.payload, len);
+    packet.checksum = cksum_finish(ctx->cfg.cksum_kind, partial, acknum, acknum);
+    return packet;
 }
 
-/* called from layer 3, when a packet arrives for layer 4 */
-void A_input(struct pkt packet)
+int is_SACKed(const struct pkt *packet, int i)
 {
-    inform(__FUNCTION__, "Recv ACK[%d]", packet.acknum);    
-    int window_range = (window_right - window_left + 1 + BUF_SZ) % BUF_SZ;
-    // Case1: CheckSum Failed
-    if(!checksum(packet)){
-        inform(__FUNCTION__, "Checksum Failed, Dropped the packet");
-        return;
-    }
-
-    // Case2: ACK is Wrong
-    int ack_shift = is_ACK_valid(&packet, left_seqnum, left_seqnum + window_range - 1);
-    if(ack_shift == 0){
-        inform(__FUNCTION__, "Recv ACK[%d], Ignore", packet.acknum);
-    }
-
-    // Case3: ACK is Correct
-    else {
-        inform(__FUNCTION__, "Right ACK Num, Timer Stopped", packet.acknum);
-        stoptimer(A);
-
-        uint32_t loc = (window_left + ack_shift - 1 + BUF_SZ) % BUF_SZ;
-        clean_pkt(sender_buffer, loc);
-        int shift = get_sender_window_shift(window_left, sender_buf_upper);
-
-        window_left = (window_left + shift) % BUF_SZ;
-        left_seqnum = get_next_Seqnum(left_seqnum, shift);
-
-        if(sender_buf_upper > window_right && shift > 0){
-            int shift_right = (sender_buf_upper >= (window_right + shift)) ? shift : sender_buf_upper - window_right;
-            inform(__FUNCTION__, "Slide right & Send Cached Msg");
-            send_range(A, A_seqnum, shift_right);
-            window_right = (window_right + shift_right) % BUF_SZ;
-        } 
-
-        if (window_left != window_right)
-            starttimer(A, TIMEOUT);
-    }
+    return i < packet->length * 8 && (((const uint8_t *)packet->payload)[i / 8] >> (i % 8) & 1);
 }
 
-/* called when A's timer goes off */
-void A_timerinterrupt(void)
+void send_ack(struct sim_ctx *ctx, int AorB, uint32_t acknum)
 {
-    // A Time Out send the packet n
-    inform(__FUNCTION__, "Resend Seq[%d]", left_seqnum);
-    send_packet(A, left_seqnum, sender_buffer[window_left]);
-    inform(__FUNCTION__, "Start Timer");
-    starttimer(A, TIMEOUT);
+    const char* sender = A == AorB ? "A_input" : "B_input";
+    inform(ctx, sender, "Send ACK[%u]", acknum);
+    struct pkt packet = make_ack(ctx, acknum);
+    tolayer3(ctx, AorB, &packet);
 }
 
-/* the following routine will be called once (only) before any other */
-/* entity A routines are called. You can use it to do any initialization */
-void A_init(void)
+int get_sender_window_shift(struct sim_ctx *ctx, uint32_t start, uint32_t end)
 {
-    A_seqnum = 0;
-    left_seqnum = 0;
-    sender_buf_upper = 0;
-    window_left = 0;
-    window_right = 0;
+    int bufsz = ctx->proto->buf_size;
+    return bit_run(ctx->proto->acked, bufsz, start, (end - start + bufsz) % bufsz);
 }
 
-/* Note that with simplex transfer from a-to-B, there is no B_output() */
-
-/* called from layer 3, when a packet arrives for layer 4 at B*/
-void B_input(struct pkt packet)
+// how many seqnums from B_acknum on have arrived without a gap
+int get_receiver_window_shift(struct sim_ctx *ctx)
 {
-    int last_seqnum = get_last_Seqnum(B_acknum);
-    inform(__FUNCTION__, "Recv Seq[%d] | Msg: %.20s", packet.seqnum, packet.payload);    
-    
-    // Case 1: CheckSum Failed
-    // Dropped the packet
-    if(!checksum(packet)){
-        inform(__FUNCTION__, "CheckSum failed"); 
-        return;
-    } 
-
-    int seq_shift = is_Seq_valid(&packet, B_acknum, (B_acknum + WINDOW_SZ) % (WINDOW_SZ + 1));
-    // Case 2: Recv Invalid ACK[n] (n in [B_acknum-N, B_acknum-1])
-    // Send ACK(n)
-    if(seq_shift == 0){
-        inform(__FUNCTION__, "ACK Out of Window Seq[%d]", packet.seqnum);
-        send_ack(B, packet.seqnum);
-    }
-    // Case 3: Recv ACK[n] (n in [B_acknum, B_acknum+N-1])
-    // Send ACK(n)
-    // If 
-    else {
-        send_ack(B, packet.seqnum);
-        cache_receiver_msg(packet.payload, seq_shift - 1);
-        int shift = get_receiver_window_shift(0, WINDOW_SZ - 1);
-        B_acknum = get_next_Seqnum(B_acknum, shift);
-        for(int i = 1; i <= shift; i++){
-            uint32_t loc = (i + seq_shift - 2 + WINDOW_SZ)%WINDOW_SZ;
-            tolayer5(B, receiver_buffer[loc]);
-            clean_pkt(receiver_buffer, loc);
-        }
-        
-    }
+    return bit_run(ctx->proto->received, ctx->cfg.window, ctx->proto->receiver_left, ctx->cfg.window);
 }
 
-/* called when B's timer goes off */
-void B_timerinterrupt(void)
+// ACK what B has, now
+void ack_now(struct sim_ctx *ctx)
 {
-    printf("B timer time Out\n");
+    struct proto_state *s = ctx->proto;
+    if(s->ack_pending > 0 && ctx->cfg.ack_every > 1)
+        stoptimer(ctx, B);
+    s->ack_pending = 0;
+    send_ack(ctx, B, s->B_acknum);
 }
 
-/* the following rouytine will be called once (only) before any other */
-/* entity B routines are called. You can use it to do any initialization */
-void B_init(void)
+// one more in-order packet: ACK every ack_every-th, or when B's timer
+// goes off ack_delay after the first of them
+void ack_delayed(struct sim_ctx *ctx)
 {
-    B_acknum = 0;
-    receiver_buf_upper = 0;
+    struct proto_state *s = ctx->proto;
+    if(++s->ack_pending >= ctx->cfg.ack_every)
+        ack_now(ctx);
+    else if(s->ack_pending == 1)
+        starttimer(ctx, B, ctx->cfg.ack_delay);
 }
 
-/************ STUDENTS NEED TO MODIFY ABOVE CODE************/
-/*****************************************************************
-***************** NETWORK EMULATION CODE STARTS BELOW ***********
-The code below emulates the layer 3 and below network environment:
-    - emulates the transmission and delivery (possibly with bit-level corruption
-        and packet loss) of packets across the layer 3/4 interface
-    - handles the starting/stopping of a timer, and generates timer
-        interrupts (resulting in calling students timer handler).
-    - generates message to be sent (passed from later 5 to 4)
-THERE IS NOT REASON THAT ANY STUDENT SHOULD HAVE TO READ OR UNDERSTAND
-THE CODE BELOW.  YOU SHOULD NOT TOUCH, OR REFERENCE (in your code) ANY
-OF THE DATA STRUCTURES BELOW.  If you're interested in how I designed
-the emulator, you're welcome to look at the code - but again, you should have
-to, and you definitely should not have to modify
-******************************************************************/
-
-struct event
-{
-    float evtime;       /* event time */
-    int evtype;         /* event type code */
-    int eventity;       /* entity where event occurs */
-    struct pkt *pktptr; /* ptr to packet (if any) assoc w/ this event */
-    struct event *prev;
-    struct event *next;
-};
-struct event *evlist = NULL; /* the event list */
-
-/* possible events: */
-#define TIMER_INTERRUPT 0
-#define FROM_LAYER5 1
-#define FROM_LAYER3 2
-
-#define OFF 0
-#define ON 1
-#define A 0
-#define B 1
-
-int TRACE = 1;   /* for my debugging */
-int nsim = 0;    /* number of messages from 5 to 4 so far */
-int nsimmax = 0; /* number of msgs to generate, then stop */
-float g_time = 0.000;
-float lossprob;    /* probability that a packet is dropped  */
-float corruptprob; /* probability that one bit is packet is flipped */
-float lambda;      /* arrival rate of messages from layer 5 */
-int ntolayer3;     /* number sent into layer 3 */
-int nlost;         /* number lost in media */
-int ncorrupt;      /* number corrupted by media*/
-
-void init(int argc, char **argv);
-void generate_next_arrival(void);
-void insertevent(struct event *p);
-
-int main(int argc, char **argv)
-{
-    struct event *eventptr;
-    struct msg msg2give;
-    struct pkt pkt2give;
-
-    int i, j;
-    char c;
-
-    init(argc, argv);
-    A_init();
-    B_init();
-
-    while (1)
-    {
-        eventptr = evlist; /* get next event to simulate */
-        if (eventptr == NULL)
-            goto terminate;
-        evlist = evlist->next; /* remove this event from event list */
-        if (evlist != NULL)
-            evlist->prev = NULL;
-        if (TRACE >= 2)
-        {
-            printf("\nEVENT time: %f,", eventptr->evtime);
-            printf("  type: %d", eventptr->evtype);
-            if (eventptr->evtype == 0)
-                printf(", timerinterrupt  ");
-            else if (eventptr->evtype == 1)
-                printf(", fromlayer5 ");
-            else
-                printf(", fromlayer3 ");
-            printf(" entity: %d\n", eventptr->eventity);
-        }
-        g_time = eventptr->evtime; /* update time to next event time */
-        if (eventptr->evtype == FROM_LAYER5)
-        {
-            if (nsim < nsimmax)
-            {
-                if (nsim + 1 < nsimmax)
-                    generate_next_arrival(); /* set up future arrival */
-                /* fill in msg to give with string of same letter */
-                j = nsim % 26;
-                for (i = 0; i < 20; i++)
-                    msg2give.data[i] = 97 + j;
-//                msg2give.data[19] = 0;
-                if (TRACE > 2)
-                {
-                    printf("          MAINLOOP: data given to student: ");
-                    for (i = 0; i < 20; i++)
-                        printf("%c", msg2give.data[i]);
-                    printf("\n");
-                }
-                nsim++;
-                if (eventptr->eventity == A)
-                    A_output(msg2give);
-                else
-                    B_output(msg2give);
-            }
-        }
-        else if (eventptr->evtype == FROM_LAYER3)
-        {
-            pkt2give.seqnum = eventptr->pktptr->seqnum;
-            pkt2give.acknum = eventptr->pktptr->acknum;
-            pkt2give.checksum = eventptr->pktptr->checksum;
-            for (i = 0; i < 20; i++)
-                pkt2give.payload[i] = eventptr->pktptr->payload[i];
-            if (eventptr->eventity == A) /* deliver packet by calling */
-                A_input(pkt2give);       /* appropriate entity */
-            else
-                B_input(pkt2give);
-            free(eventptr->pktptr); /* free the memory for packet */
-        }
-        else if (eventptr->evtype == TIMER_INTERRUPT)
-        {
-            if (eventptr->eventity == A)
-                A_timerinterrupt();
-            else
-                B_timerinterrupt();
-        }
-        else
-        {
-            printf("INTERNAL PANIC: unknown event type \n");
-        }
-        free(eventptr);
-    }
-
-    terminate:
-    printf(
-            " Simulator terminated at time %f\n after sending %d msgs from layer5\n",
-            g_time, nsim);
+// anything buffered out of order, i.e. a gap the sender should hear of
+int has_gap(struct sim_ctx *ctx)
+{
+    return ctx->proto->receiver_held > 0;
 }
 
-void init(int argc, char **argv) /* initialize the simulator */
+// slots renumber, so the timer heap and the acked bits move with them
+void grow_sender_buffer(struct sim_ctx *ctx)
 {
-    int i;
-    float sum, avg;
-    float jimsrand();
-
-    if (argc != 6)
-    {
-        printf("usage: %s  num_sim  prob_loss  prob_corrupt  interval  debug_level\n", argv[0]);
+    struct proto_state *s = ctx->proto;
+    int cap = s->buf_size;
+    int left = s->window_left;
+    int count = (s->sender_buf_upper - left + cap) % cap;
+    uint64_t *acked = (uint64_t*)calloc(MAP_WORDS(2 * cap), sizeof(uint64_t));
+    int *timer_heap = (int*)realloc(s->timer_heap, sizeof(int) * 2 * cap);
+    int *timer_pos = (int*)malloc(sizeof(int) * 2 * cap);
+    if(acked == NULL || timer_heap == NULL || timer_pos == NULL){
+        printf("INTERNAL PANIC: out of memory for %d queued messages\n", count);
         exit(1);
     }
-
-    nsimmax = atoi(argv[1]);
-    lossprob = atof(argv[2]);
-    corruptprob = atof(argv[3]);
-    lambda = atof(argv[4]);
-    TRACE = atoi(argv[5]);
-    printf("-----  Selective Repeat Network Simulator Version 1.1 -------- \n\n");
-    printf("the number of messages to simulate: %d\n", nsimmax);
-    printf("packet loss probability: %f\n", lossprob);
-    printf("packet corruption probability: %f\n", corruptprob);
-    printf("average time between messages from sender's layer5: %f\n", lambda);
-    printf("TRACE: %d\n", TRACE);
-
-    //srand((unsigned)time(NULL)); /* init random number generator */
-    srand(1);
-    sum = 0.0;   /* test random number generator for students */
-    for (i = 0; i < 1000; i++)
-        sum = sum + jimsrand(); /* jimsrand() should be uniform in [0,1] */
-    avg = sum / 1000.0;
-    if (avg < 0.25 || avg > 0.75)
-    {
-        printf("It is likely that random number generation on your machine\n");
-        printf("is different from what this emulator expects.  Please take\n");
-        printf("a look at the routine jimsrand() in the emulator code. Sorry. \n");
-        exit(1);
+    s->sender_buffer = (char*)ring_grow(s->sender_buffer, ctx->cfg.payload_size, cap, left, count);
+    s->sender_cksum = (uint32_t*)ring_grow(s->sender_cksum, sizeof(uint32_t), cap, left, count);
+    s->sent_at = (float*)ring_grow(s->sent_at, sizeof(float), cap, left, count);
+    s->deadline = (float*)ring_grow(s->deadline, sizeof(float), cap, left, count);
+    for(int i = 0; i < count; i++)
+        if(bit_test(s->acked, (left + i) % cap))
+            bit_set(acked, i);
+    for(int i = 0; i < 2 * cap; i++)
+        timer_pos[i] = -1;
+    for(int i = 0; i < s->timer_count; i++){
+        timer_heap[i] = (timer_heap[i] - left + cap) % cap;
+        timer_pos[timer_heap[i]] = i;
     }
-
-    ntolayer3 = 0;
-    nlost = 0;
-    ncorrupt = 0;
-
-    g_time = 0.0;              /* initialize g_time to 0.0 */
-    generate_next_arrival(); /* initialize event list */
+    free(s->acked);
+    free(s->timer_pos);
+    s->acked = acked;
+    s->timer_heap = timer_heap;
+    s->timer_pos = timer_pos;
+    s->window_right = (s->window_right - left + cap) % cap;
+    s->window_left = 0;
+    s->sender_buf_upper = count;
+    s->buf_size = 2 * cap;
+}
+
+void cache_sender_msg(struct sim_ctx *ctx, struct msg* msg)
+{
+    struct proto_state *s = ctx->proto;
+    if((s->sender_buf_upper + 1) % s->buf_size == s->window_left)
+        grow_sender_buffer(ctx);
+    memcpy(PAYLOAD_SLOT(ctx, s->sender_buffer, s->sender_buf_upper), msg->data, msg->length);
+    bit_clear(s->acked, s->sender_buf_upper);
+    s->sender_cksum[s->sender_buf_upper] = cksum_payload(ctx->cfg.cksum_kind, msg->data, msg->length);
+    s->sender_buf_upper = (s->sender_buf_upper + 1) % s->buf_size;
+}
+
+// offset: how far the packet's seqnum is ahead of B_acknum
+void cache_receiver_msg(struct sim_ctx *ctx, const char *payload, int length, int offset)
+{
+    struct proto_state *s = ctx->proto;
+    int slot = receiver_slot(ctx, offset);
+    if(!bit_test(s->received, slot)){
+        bit_set(s->received, slot);
+        s->receiver_held++;
+    }
+    memcpy(PAYLOAD_SLOT(ctx, s->receiver_buffer, slot), payload, length);
 }
 
-/****************************************************************************/
-/* jimsrand(): return a float in range [0,1].  The routine below is used to */
-/* isolate all random number generation in one location.  We assume that the*/
-/* system-supplied rand() function return an int in therange [0,mmm]        */
-/****************************************************************************/
-float jimsrand(void)
-{
-    double mmm = RAND_MAX;
-    float x;          /* individual students may need to change mmm */
-    x = rand() / mmm; /* x should be uniform in [0,1] */
-    return (x);
+/* called from layer 5, passed the data to be sent to other side */
+void A_output(struct sim_ctx *ctx, struct msg message)
+{
+    struct proto_state *s = ctx->proto;
+    LOG(ctx, LOG_INFO, "------------------------------\n");
+    cache_sender_msg(ctx, &message);
+    int bufsz = s->buf_size;
+    if((s->window_right - s->window_left + bufsz) % bufsz < ctx->cfg.window){
+        int last = (s->sender_buf_upper + bufsz - 1) % bufsz;
+        send_packet(ctx, A, s->A_seqnum, message.data, s->sender_cksum[last]);
+        s->sent_at[last] = ctx->time;
+        timer_set(ctx, last);
+        timer_sync(ctx);
+        s->A_seqnum = seq_next(ctx, s->A_seqnum, 1);
+        s->window_right = (s->window_right + 1) % bufsz;
+        sim_window(ctx, (s->window_right - s->window_left + bufsz) % bufsz);
+    } else {
+        inform(ctx, __FUNCTION__, "Window is full, BUF the msg: %.*s", PREVIEW(message.length), message.data);
+    }
+    sim_backlog(ctx, (s->sender_buf_upper - s->window_right + bufsz) % bufsz);
 }
 
-/********************* EVENT HANDLING ROUTINES *******/
-/*  The next set of routines handle the event list   */
-/*****************************************************/
-
-void generate_next_arrival(void)
+/* need be completed only for extra credit */
+void B_output(struct sim_ctx *ctx, struct msg message)
 {
-    double x, log(), ceil();
-    struct event *evptr;
-    float ttime;
-    int tempint;
-
-    if (TRACE > 2)
-        printf("          GENERATE NEXT ARRIVAL: creating new arrival\n");
-
-    x = lambda * jimsrand() * 2; /* x is uniform on [0,2*lambda] */
-    /* having mean of lambda        */
-    evptr = (struct event *)malloc(sizeof(struct event));
-    evptr->evtime = g_time + x;
-    evptr->evtype = FROM_LAYER5;
-    if (BIDIRECTIONAL && (jimsrand() > 0.5))
-        evptr->eventity = B;
-    else
-        evptr->eventity = A;
-    insertevent(evptr);
+    inform(ctx, __FUNCTION__, "Got Msg");
 }
 
-void insertevent(struct event *p)
+/* called from layer 3, when a packet arrives for layer 4 */
+void A_input(struct sim_ctx *ctx, const struct pkt *packet)
 {
-    struct event *q, *qold;
+    struct proto_state *s = ctx->proto;
+    inform(ctx, __FUNCTION__, "Recv ACK[%u]", (uint32_t)packet->acknum);    
+    int bufsz = s->buf_size;
+    int outstanding = (s->window_right - s->window_left + bufsz) % bufsz;
+    // Case1: CheckSum Failed
+    if(!checksum(ctx, packet)){
+        inform(ctx, __FUNCTION__, "Checksum Failed, Dropped the packet");
+        return;
+    }
 
-    if (TRACE > 2)
-    {
-        printf("            INSERTEVENT: time is %lf\n", g_time);
-        printf("            INSERTEVENT: future time will be %lf\n", p->evtime);
+    // Case2: ACK is Wrong, or older than the window
+    uint32_t acknum = (uint32_t)packet->acknum;
+    uint32_t cum = seq_offset(ctx, acknum, s->left_seqnum);
+    if((ctx->cfg.seq_space != 0 && acknum >= ctx->cfg.seq_space) || packet->length != sack_len(ctx) ||
+       cum > (uint32_t)outstanding){
+        inform(ctx, __FUNCTION__, "Recv ACK[%u], Ignore", acknum);
+        return;
     }
-    q = evlist; /* q points to header of list in which p struct inserted */
-    if (q == NULL)
-    { /* list is empty */
-        evlist = p;
-        p->next = NULL;
-        p->prev = NULL;
+
+    // Case3: ACK is Correct
+    // Everything before acknum is acked, and whatever the bitmap says
+    float newest = -1;
+    int reach = (int)cum + packet->length * 8; // the bitmap says nothing beyond
+    if(reach > outstanding)
+        reach = outstanding;
+    for(int i = 0; i < reach; i++){
+        uint32_t loc = (s->window_left + i) % bufsz;
+        if(i >= (int)cum && !is_SACKed(packet, i - cum))
+            continue;
+        if(bit_test(s->acked, loc))
+            continue; // acked before
+        if(s->sent_at[loc] > newest)
+            newest = s->sent_at[loc];
+        s->sent_at[loc] = -1;
+        timer_clear(ctx, loc);
+        bit_set(s->acked, loc);
     }
-    else
-    {
-        for (qold = q; q != NULL && p->evtime > q->evtime; q = q->next)
-            qold = q;
-        if (q == NULL)
-        { /* end of list */
-            qold->next = p;
-            p->prev = qold;
-            p->next = NULL;
-        }
-        else if (q == evlist)
-        { /* front of list */
-            p->next = evlist;
-            p->prev = NULL;
-            p->next->prev = p;
-            evlist = p;
-        }
-        else
-        { /* middle of list */
-            p->next = q;
-            p->prev = q->prev;
-            q->prev->next = p;
-            q->prev = p;
-        }
+    // one sample, from the latest first send among them (Karn)
+    if(newest >= 0)
+        rto_sample(&ctx->rto, ctx->time - newest);
+
+    int shift = get_sender_window_shift(ctx, s->window_left, s->window_right);
+    s->window_left = (s->window_left + shift) % bufsz;
+    s->left_seqnum = seq_next(ctx, s->left_seqnum, shift);
+
+    int room = ctx->cfg.window - (s->window_right - s->window_left + bufsz) % bufsz;
+    int cached = (s->sender_buf_upper - s->window_right + bufsz) % bufsz;
+    int shift_right = cached < room ? cached : room;
+    if(shift_right > 0){
+        inform(ctx, __FUNCTION__, "Slide right & Send Cached Msg");
+        send_range(ctx, A, s->A_seqnum, shift_right);
+        s->A_seqnum = seq_next(ctx, s->A_seqnum, shift_right);
+        s->window_right = (s->window_right + shift_right) % bufsz;
     }
+
+    sim_window(ctx, (s->window_right - s->window_left + bufsz) % bufsz);
+    sim_backlog(ctx, (s->sender_buf_upper - s->window_right + bufsz) % bufsz);
+
+    timer_sync(ctx);
 }
 
-void printevlist(void)
-{
-    struct event *q;
-    int i;
-    printf("--------------\nEvent List Follows:\n");
-    for (q = evlist; q != NULL; q = q->next)
-    {
-        printf("Event time: %f, type: %d entity: %d\n", q->evtime, q->evtype,
-               q->eventity);
+/* called when A's timer goes off */
+void A_timerinterrupt(struct sim_ctx *ctx)
+{
+    struct proto_state *s = ctx->proto;
+    s->armed = -1;
+    // back off once per round, when the oldest packet runs out, not for
+    // every later loss whose timer expires on its own
+    if(s->timer_pos[s->window_left] >= 0 && s->deadline[s->window_left] <= ctx->time)
+        rto_backoff(&ctx->rto);
+    // A Time Out send every packet whose own timer has run out
+    while(s->timer_count > 0 && s->deadline[s->timer_heap[0]] <= ctx->time){
+        int slot = s->timer_heap[0];
+        int bufsz = s->buf_size;
+        uint32_t seqnum = seq_next(ctx, s->left_seqnum, (slot - s->window_left + bufsz) % bufsz);
+        inform(ctx, __FUNCTION__, "Resend Seq[%u]", seqnum);
+        sim_retransmit(ctx);
+        send_packet(ctx, A, seqnum, PAYLOAD_SLOT(ctx, s->sender_buffer, slot), s->sender_cksum[slot]);
+        s->sent_at[slot] = -1;
+        timer_set(ctx, slot);
     }
-    printf("--------------\n");
-}
-
-/********************** Student-callable ROUTINES ***********************/
-
-/* called by students routine to cancel a previously-started timer */
-void stoptimer(int AorB /* A or B is trying to stop timer */)
-{
-    struct event *q, *qold;
-
-    if (TRACE > 2)
-        printf("          STOP TIMER: stopping timer at %f\n", g_time);
-    /* for (q=evlist; q!=NULL && q->next!=NULL; q = q->next)  */
-    for (q = evlist; q != NULL; q = q->next)
-        if ((q->evtype == TIMER_INTERRUPT && q->eventity == AorB))
-        {
-            /* remove this event */
-            if (q->next == NULL && q->prev == NULL)
-                evlist = NULL;        /* remove first and only event on list */
-            else if (q->next == NULL) /* end of list - there is one in front */
-                q->prev->next = NULL;
-            else if (q == evlist)
-            { /* front of list - there must be event after */
-                q->next->prev = NULL;
-                evlist = q->next;
-            }
-            else
-            { /* middle of list */
-                q->next->prev = q->prev;
-                q->prev->next = q->next;
-            }
-            free(q);
-            return;
-        }
-    printf("Warning: unable to cancel your timer. It wasn't running.\n");
+    timer_sync(ctx);
 }
 
-void starttimer(int AorB /* A or B is trying to stop timer */, float increment)
+/* allocate the state of both entities, once per simulation context */
+struct proto_state *proto_new(struct sim_ctx *ctx)
 {
-    struct event *q;
-    struct event *evptr;
-
-    if (TRACE > 2)
-        printf("          START TIMER: starting timer at %f\n", g_time);
-    /* be nice: check to see if timer is already started, if so, then  warn */
-    /* for (q=evlist; q!=NULL && q->next!=NULL; q = q->next)  */
-    for (q = evlist; q != NULL; q = q->next)
-        if ((q->evtype == TIMER_INTERRUPT && q->eventity == AorB))
-        {
-            printf("Warning: attempt to start a timer that is already started\n");
-            return;
-        }
+    // a resend of the packet before the receiver's window must not
+    // look like one in it, so SR needs twice the window
+    if(ctx->cfg.seq_space != 0 && ctx->cfg.seq_space / 2 < (uint32_t)ctx->cfg.window){
+        printf("%s: a window of %d needs a sequence space of at least %d\n", sim_name,
+               ctx->cfg.window, 2 * ctx->cfg.window);
+        exit(1);
+    }
+    window_check(ctx);
+    int bufsz = ctx->cfg.buf_size;
+    struct proto_state *s = (struct proto_state*)calloc(1, sizeof(struct proto_state));
+    if(s == NULL){
+        printf("INTERNAL PANIC: out of memory for the protocol state\n");
+        exit(1);
+    }
+    s->buf_size = bufsz;
+    s->sender_buffer = (char*)malloc((size_t)bufsz * ctx->cfg.payload_size);
+    s->sender_cksum = (uint32_t*)malloc(sizeof(uint32_t) * bufsz);
+    s->sent_at = (float*)malloc(sizeof(float) * bufsz);
+    s->acked = (uint64_t*)malloc(sizeof(uint64_t) * MAP_WORDS(bufsz));
+    s->deadline = (float*)malloc(sizeof(float) * bufsz);
+    s->timer_heap = (int*)malloc(sizeof(int) * bufsz);
+    s->timer_pos = (int*)malloc(sizeof(int) * bufsz);
+    s->sack = (uint8_t*)malloc(SACK_BYTES(ctx));
+    s->receiver_buffer = (char*)malloc((size_t)ctx->cfg.window * ctx->cfg.payload_size);
+    s->received = (uint64_t*)malloc(sizeof(uint64_t) * MAP_WORDS(ctx->cfg.window));
+    if(s->sender_buffer == NULL || s->sender_cksum == NULL || s->sent_at == NULL || s->acked == NULL ||
+       s->deadline == NULL || s->timer_heap == NULL || s->timer_pos == NULL){
+        printf("INTERNAL PANIC: out of memory for %d queued messages\n", bufsz);
+        exit(1);
+    }
+    if(s->sack == NULL || s->receiver_buffer == NULL || s->received == NULL){
+        printf("INTERNAL PANIC: out of memory for a window of %d\n", ctx->cfg.window);
+        exit(1);
+    }
+    return s;
+}
 
-    /* create future event for when timer goes off */
-    evptr = (struct event *)malloc(sizeof(struct event));
-    evptr->evtime = g_time + increment;
-    evptr->evtype = TIMER_INTERRUPT;
-    evptr->eventity = AorB;
-    insertevent(evptr);
+void proto_free(struct proto_state *s)
+{
+    free(s->sender_buffer);
+    free(s->sender_cksum);
+    free(s->sent_at);
+    free(s->acked);
+    free(s->deadline);
+    free(s->timer_heap);
+    free(s->timer_pos);
+    free(s->sack);
+    free(s->receiver_buffer);
+    free(s->received);
+    free(s);
 }
 
-/************************** TOLAYER3 ***************/
-void tolayer3(int AorB /* A or B is trying to stop timer */, struct pkt packet)
+/* the following routine will be called once (only) before any other */
+/* entity A routines are called. You can use it to do any initialization */
+void A_init(struct sim_ctx *ctx)
 {
-    struct pkt *mypktptr;
-    struct event *evptr, *q;
-    float lastime, x;
-    int i;
+    struct proto_state *s = ctx->proto;
+    s->A_seqnum = 0;
+    s->left_seqnum = 0;
+    s->sender_buf_upper = 0;
+    s->window_left = 0;
+    s->window_right = 0;
+    s->timer_count = 0;
+    s->armed = -1;
+    for(int i = 0; i < s->buf_size; i++)
+        s->timer_pos[i] = -1;
+    memset(s->acked, 0, sizeof(uint64_t) * MAP_WORDS(s->buf_size));
+}
 
-    ntolayer3++;
+/* Note that with simplex transfer from a-to-B, there is no B_output() */
 
-    /* simulate losses: */
-    if (jimsrand() < lossprob)
-    {
-        nlost++;
-        if (TRACE > 0)
-            printf("          TOLAYER3: packet being lost\n");
+/* called from layer 3, when a packet arrives for layer 4 at B*/
+void B_input(struct sim_ctx *ctx, const struct pkt *packet)
+{
+    struct proto_state *s = ctx->proto;
+    inform(ctx, __FUNCTION__, "Recv Seq[%u] | Msg: %.*s", (uint32_t)packet->seqnum, PREVIEW(packet->length), packet->payload);    
+    
+    // Case 1: CheckSum Failed
+    // Dropped the packet
+    uint32_t seqnum = (uint32_t)packet->seqnum;
+    if(!checksum(ctx, packet) || (ctx->cfg.seq_space != 0 && seqnum >= ctx->cfg.seq_space)){
+        inform(ctx, __FUNCTION__, "CheckSum failed"); 
         return;
-    }
+    } 
 
-    /* make a copy of the packet student just gave me since he/she may decide */
-    /* to do something with the packet after we return back to him/her */
-    mypktptr = (struct pkt *)malloc(sizeof(struct pkt));
-    mypktptr->seqnum = packet.seqnum;
-    mypktptr->acknum = packet.acknum;
-    mypktptr->checksum = packet.checksum;
-    for (i = 0; i < 20; i++)
-        mypktptr->payload[i] = packet.payload[i];
-    if (TRACE > 2)
-    {
-        printf("          TOLAYER3: seq: %d, ack %d, check: %d ", mypktptr->seqnum,
-               mypktptr->acknum, mypktptr->checksum);
-        for (i = 0; i < 20; i++)
-            printf("%c", mypktptr->payload[i]);
-        printf("\n");
+    uint32_t offset = seq_offset(ctx, seqnum, s->B_acknum);
+    // Case 2: Recv Seq[n] (n in [B_acknum-N, B_acknum-1]), delivered already
+    // Its ACK got lost, ACK again
+    if(offset >= (uint32_t)ctx->cfg.window){
+        inform(ctx, __FUNCTION__, "Seq[%u] Delivered Already", seqnum);
+        ack_now(ctx);
     }
-
-    /* create future event for arrival of packet at the other side */
-    evptr = (struct event *)malloc(sizeof(struct event));
-    evptr->evtype = FROM_LAYER3;      /* packet will pop out from layer3 */
-    evptr->eventity = (AorB + 1) % 2; /* event occurs at other entity */
-    evptr->pktptr = mypktptr;         /* save ptr to my copy of packet */
-    /* finally, compute the arrival time of packet at the other end.
-       medium can not reorder, so make sure packet arrives between 1 and 10
-       time units after the latest arrival time of packets
-       currently in the medium on their way to the destination */
-    lastime = g_time;
-    /* for (q=evlist; q!=NULL && q->next!=NULL; q = q->next) */
-    for (q = evlist; q != NULL; q = q->next)
-        if ((q->evtype == FROM_LAYER3 && q->eventity == evptr->eventity))
-            lastime = q->evtime;
-    evptr->evtime = lastime + 1 + 9 * jimsrand();
-
-    /* simulate corruption: */
-    if (jimsrand() < corruptprob)
-    {
-        ncorrupt++;
-        if ((x = jimsrand()) < .75)
-            mypktptr->payload[0] = 'Z'; /* corrupt payload */
-        else if (x < .875)
-            mypktptr->seqnum = 999999;
+    // Case 3: Recv Seq[n] (n in [B_acknum, B_acknum+N-1])
+    // Buffer it, pass up whatever is now in order
+    else {
+        cache_receiver_msg(ctx, packet->payload, packet->length, offset);
+        int shift = get_receiver_window_shift(ctx);
+        for(int i = 0; i < shift; i++){
+            uint32_t loc = receiver_slot(ctx, i);
+            tolayer5(ctx, B, PAYLOAD_SLOT(ctx, s->receiver_buffer, loc), ctx->cfg.payload_size);
+            bit_clear(s->received, loc);
+        }
+        s->receiver_held -= shift;
+        s->receiver_left = receiver_slot(ctx, shift);
+        s->B_acknum = seq_next(ctx, s->B_acknum, shift);
+        // ACK a gap at once, in-order arrivals can wait for company
+        if(offset == 0 && !has_gap(ctx))
+            ack_delayed(ctx);
         else
-            mypktptr->acknum = 999999;
-        if (TRACE > 0)
-            printf("          TOLAYER3: packet being corrupted\n");
+            ack_now(ctx);
     }
+}
 
-    if (TRACE > 2)
-        printf("          TOLAYER3: scheduling arrival on other side\n");
-    insertevent(evptr);
+/* called when B's timer goes off */
+void B_timerinterrupt(struct sim_ctx *ctx)
+{
+    struct proto_state *s = ctx->proto;
+    inform(ctx, __FUNCTION__, "ACK Delay Over, %d Pending", s->ack_pending);
+    s->ack_pending = 0; // the timer is no longer running
+    send_ack(ctx, B, s->B_acknum);
 }
 
-void tolayer5(int AorB, char datasent[20])
+/* the following rouytine will be called once (only) before any other */
+/* entity B routines are called. You can use it to do any initialization */
+void B_init(struct sim_ctx *ctx)
 {
-    int i;
-    if (TRACE > 2)
-    {
-        printf("          TOLAYER5: data received: ");
-        for (i = 0; i < 20; i++)
-            printf("%c", datasent[i]);
-        printf("\n");
-    }
+    struct proto_state *s = ctx->proto;
+    s->B_acknum = 0;
+    s->ack_pending = 0;
+    s->receiver_left = 0;
+    s->receiver_held = 0;
+    memset(s->received, 0, sizeof(uint64_t) * MAP_WORDS(ctx->cfg.window));
 }
+
+/************ STUDENTS NEED TO MODIFY ABOVE CODE************/
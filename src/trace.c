@@ -0,0 +1,68 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "trace.h"
+
+static const char *action_names[TR_NACTIONS] = {
+    "event", "send", "lost", "corrupt", "deliver",
+    "timer_start", "timer_stop", "timer_restart"};
+
+/* indexed by the emulator's TIMER_INTERRUPT, FROM_LAYER5, FROM_LAYER3 */
+static const char *evtype_names[] = {"timerinterrupt", "fromlayer5", "fromlayer3"};
+
+void trace_flush(struct tracer *tr)
+{
+    size_t n = tr->next - tr->ring;
+
+    if (tr->ok && n > 0 && fwrite(tr->ring, sizeof(tr->ring[0]), n, tr->fp) != n)
+    {
+        printf("Warning: trace file write failed, tracing stopped\n");
+        tr->ok = 0;
+    }
+    tr->next = tr->ring;
+}
+
+struct tracer *trace_open(const char *path)
+{
+    struct trace_hdr hdr;
+    struct tracer *tr;
+
+    tr = (struct tracer *)malloc(sizeof(*tr));
+    if (tr == NULL)
+        return NULL;
+    tr->fp = fopen(path, "wb");
+    if (tr->fp == NULL)
+    {
+        free(tr);
+        return NULL;
+    }
+    setvbuf(tr->fp, NULL, _IONBF, 0); /* whole rings go straight to write() */
+    memcpy(hdr.magic, TRACE_MAGIC, sizeof(hdr.magic));
+    hdr.version = TRACE_VERSION;
+    hdr.recsize = sizeof(struct trace_rec);
+    fwrite(&hdr, sizeof(hdr), 1, tr->fp);
+    tr->next = tr->ring;
+    tr->end = tr->ring + TRACE_RING;
+    tr->ok = 1;
+    return tr;
+}
+
+void trace_close(struct tracer *tr)
+{
+    if (tr == NULL)
+        return;
+    trace_flush(tr);
+    fclose(tr->fp);
+    free(tr);
+}
+
+const char *trace_action_name(int action)
+{
+    return action >= 0 && action < TR_NACTIONS ? action_names[action] : "unknown";
+}
+
+const char *trace_evtype_name(int evtype)
+{
+    return evtype >= 0 && evtype < 3 ? evtype_names[evtype] : "unknown";
+}
@@ -0,0 +1,91 @@
+#ifndef RDT_TRACE_H
+#define RDT_TRACE_H
+
+#include <stdint.h>
+#include <stdio.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/* binary event trace.  The emulator appends fixed-size records to an
+   in-memory ring that is written out in large blocks, which is far
+   cheaper than the TRACE >= 2 text output.  tracedump turns a trace
+   file back into text or CSV. */
+
+#define TRACE_MAGIC "RDTTRACE"
+#define TRACE_VERSION 1
+
+/* actions recorded */
+#define TR_EVENT 0         /* main loop dispatched an event of type evtype */
+#define TR_SEND 1          /* entity handed a packet to layer 3 */
+#define TR_LOST 2          /* that packet was lost in the medium */
+#define TR_CORRUPT 3       /* a packet for entity was corrupted in the medium */
+#define TR_DELIVER 4       /* entity passed data up to layer 5 */
+#define TR_TIMER_START 5
+#define TR_TIMER_STOP 6
+#define TR_TIMER_RESTART 7
+#define TR_NACTIONS 8
+
+struct trace_hdr
+{
+    char magic[8];    /* TRACE_MAGIC, not NUL terminated */
+    uint32_t version; /* TRACE_VERSION */
+    uint32_t recsize; /* sizeof(struct trace_rec) */
+};
+
+struct trace_rec
+{
+    float time;     /* simulated time */
+    int32_t seqnum; /* packet fields, -1 when no packet is involved */
+    int32_t acknum;
+    uint8_t action; /* TR_* */
+    uint8_t evtype; /* event type, for TR_EVENT */
+    uint8_t entity; /* A or B */
+    uint8_t pad;
+};
+
+#define TRACE_RING 8192 /* records buffered between writes */
+
+/* an open trace file and its ring.  Give each simulation running at the
+   same time its own, or none */
+struct tracer
+{
+    struct trace_rec *next; /* where the next record goes ... */
+    struct trace_rec *end;  /* ... and where the ring has to be written out */
+    FILE *fp;
+    int ok; /* cleared when a write fails */
+    struct trace_rec ring[TRACE_RING];
+};
+
+struct tracer *trace_open(const char *path); /* NULL if it can't be created */
+void trace_flush(struct tracer *tr);
+void trace_close(struct tracer *tr);
+const char *trace_action_name(int action);
+const char *trace_evtype_name(int evtype);
+
+/* append a record with one 16-byte store; the only test is for a full ring */
+static inline void trace_put(struct tracer *tr, float time, int action, int evtype, int entity,
+                             int seqnum, int acknum)
+{
+#if defined(__SSE2__)
+    /* x86 is little endian: the last word holds action, evtype, entity, pad */
+    __m128i r = _mm_set_epi32((action & 0xff) | (evtype & 0xff) << 8 | (entity & 0xff) << 16,
+                              acknum, seqnum, 0);
+    r = _mm_castps_si128(_mm_move_ss(_mm_castsi128_ps(r), _mm_set_ss(time)));
+    _mm_storeu_si128((__m128i *)tr->next, r);
+#else
+    struct trace_rec rec = {time, seqnum, acknum, (uint8_t)action, (uint8_t)evtype, (uint8_t)entity, 0};
+    *tr->next = rec;
+#endif
+    if (++tr->next == tr->end)
+        trace_flush(tr);
+}
+
+#define TRACE_REC(tr, ...)               \
+    do                                   \
+    {                                    \
+        if (tr)                          \
+            trace_put(tr, __VA_ARGS__);  \
+    } while (0)
+
+#endif
@@ -0,0 +1,73 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "trace.h"
+
+/* decode a binary trace written by a simulator run with --trace-file */
+
+#define READ_BLOCK 8192 /* records read per fread */
+
+static void print_text(const struct trace_rec *r)
+{
+    printf("%14f  %-13s entity: %c", r->time, trace_action_name(r->action),
+           r->entity == 0 ? 'A' : 'B');
+    if (r->action == TR_EVENT)
+        printf("  %s", trace_evtype_name(r->evtype));
+    if (r->seqnum != -1 || r->acknum != -1)
+        printf("  seq: %d  ack: %d", r->seqnum, r->acknum);
+    printf("\n");
+}
+
+static void print_csv(const struct trace_rec *r)
+{
+    printf("%f,%s,%s,%c,%d,%d\n", r->time, trace_action_name(r->action),
+           r->action == TR_EVENT ? trace_evtype_name(r->evtype) : "",
+           r->entity == 0 ? 'A' : 'B', r->seqnum, r->acknum);
+}
+
+int main(int argc, char **argv)
+{
+    static struct trace_rec block[READ_BLOCK];
+    struct trace_hdr hdr;
+    const char *path;
+    FILE *fp;
+    size_t n, i;
+    int csv = 0;
+
+    if (argc == 3 && strcmp(argv[1], "--csv") == 0)
+        csv = 1;
+    else if (argc != 2)
+    {
+        printf("usage: %s [--csv] tracefile\n", argv[0]);
+        return 1;
+    }
+    path = argv[argc - 1];
+
+    fp = fopen(path, "rb");
+    if (fp == NULL)
+    {
+        printf("cannot open %s\n", path);
+        return 1;
+    }
+    if (fread(&hdr, sizeof(hdr), 1, fp) != 1 ||
+        memcmp(hdr.magic, TRACE_MAGIC, sizeof(hdr.magic)) != 0 ||
+        hdr.version != TRACE_VERSION || hdr.recsize != sizeof(struct trace_rec))
+    {
+        printf("%s is not a version %d trace file\n", path, TRACE_VERSION);
+        fclose(fp);
+        return 1;
+    }
+
+    if (csv)
+        printf("time,action,evtype,entity,seqnum,acknum\n");
+    while ((n = fread(block, sizeof(block[0]), READ_BLOCK, fp)) > 0)
+        for (i = 0; i < n; i++)
+        {
+            if (csv)
+                print_csv(&block[i]);
+            else
+                print_text(&block[i]);
+        }
+    fclose(fp);
+    return 0;
+}
@@ -1,7 +1,6 @@
 import os
-import numpy as np
 import subprocess
-import re
+import json
 
 
 protocol_list = ['altBit', 'goBackN', 'selectiveRepeat']
@@ -17,30 +16,45 @@ config = {
 
 args = list(config.values())
 args = [str(i) for i in args]
-prog = re.compile(r'(?<=at time )[0-9|.]*')
-
-def test_time(protocol, args):
+# N seeded replications of one protocol in a single native run, spread
+# over all cores; each replication comes back as one JSON metrics record,
+# followed by one with the latencies of all of them merged
+def run_metrics(protocol, args, N):
     file_path = os.path.join(Compile_PATH, protocol)
     command_list = [file_path]
     command_list.extend(args)
+    command_list.extend(['--replications', str(N), '--threads', '0', '--metrics', 'json'])
     proc = subprocess.Popen( command_list, stdout=subprocess.PIPE )
     stdout, _ = proc.communicate()
     stdout = stdout.decode("utf-8")
-    time = prog.findall(stdout)[0]
-    # print(f'「{protocol}」: {time}')
-    return time
+    return [json.loads(line) for line in stdout.splitlines() if line.startswith('{')]
+
+def mean(records, key):
+    return sum(r[key] for r in records) / len(records)
 
 def multi_test(N):
-    time_list = []
     for protocol in protocol_list:
-        for i in range(N):
-            time = test_time(protocol, args)
-            time_list.append(float(time))
-        avg_time = np.mean(time_list)
-        print(f'[{protocol}]: {avg_time}ms')
+        records = run_metrics(protocol, args, N)
+        merged = records.pop()
+        avg_time = mean(records, 'time')
+        print(f'[{protocol}]: {avg_time}ms, goodput {mean(records, "goodput"):.3f}, '
+              f'retransmits {mean(records, "retransmits"):.1f}, '
+              f'latency p99 {merged["latency_p99"]:.1f}')
+
+# large windows draw the most duplicate ACKs: fast retransmit must not
+# cost more time or retransmissions than waiting for the timer
+def dup_ack_test(N):
+    base = ['4000', '0.05', '0.05', '0.01', '0', '--window', '256']
+    for dup_acks in ['0', '3']:
+        records = run_metrics('goBackN', base + ['--dup-acks', dup_acks], N)
+        records.pop()
+        print(f'[goBackN --dup-acks {dup_acks}]: {mean(records, "time"):.0f}ms, '
+              f'retransmits {mean(records, "retransmits"):.1f}, '
+              f'timeouts {mean(records, "timeouts"):.1f}')
         
         
 if __name__ == "__main__":
     multi_test(10)
+    dup_ack_test(4)
             
     